@@ -2,7 +2,7 @@
 #define _CELL_H_
 
 #include <stdint.h>
-#include <SDL.h>
+#include <stddef.h>
 
 #define CELL_ROWS_DEFAULT 100
 #define CELL_COLS_DEFAULT 100
@@ -15,6 +15,44 @@
 #define CELL_COLOR_B_DEFAULT 255
 
 #define CELL_SPAWN_PROBABILITY_DEFAULT 25
+#define CELL_TOPOLOGY_DEFAULT TOPOLOGY_DEAD
+
+/* How the edges of the body are glued together. */
+enum topology {
+	TOPOLOGY_DEAD, /* cells past the edges are dead */
+	TOPOLOGY_TORUS, /* both pairs of edges wrap */
+	TOPOLOGY_KLEIN, /* the top and bottom wrap with the columns flipped */
+	TOPOLOGY_CROSS /* both pairs of edges wrap flipped, a cross-surface */
+};
+
+#define BODY_ALIGNMENT 64 /* cache line */
+#define BODY_ROUND_UP(n) (((n) + BODY_ALIGNMENT - 1) & ~(size_t)(BODY_ALIGNMENT - 1))
+
+/*
+ * Cells are bit-packed, 64 cells of a row per word, bit x % 64 of word x / 64.
+ * 	Every row has a halo word on either side and there are halo rows above
+ * 	and below the body, one per cell of the rule's radius, so
+ * 	BODY_ROW(body, -halo)[-1] through BODY_ROW(body, rows + halo - 1)[words]
+ * 	are all valid. The halo words hold halo cells on either side.
+ */
+#define BODY_WORD_BITS 64
+#define BODY_ROW(body, y) ((body)->cells + ((ptrdiff_t)(y) + (ptrdiff_t)(body)->halo) * (ptrdiff_t)(body)->stride + 1)
+#define BODY_BIT(x) ((uint64_t)1 << ((size_t)(x) % BODY_WORD_BITS))
+#define BODY_WORD(body, x, y) (BODY_ROW(body, y)[(size_t)(x) / BODY_WORD_BITS])
+#define BODY_GET(body, x, y) ((BODY_WORD(body, x, y) & BODY_BIT(x)) != 0)
+#define BODY_SET(body, x, y) (BODY_WORD(body, x, y) |= BODY_BIT(x))
+#define BODY_TOGGLE(body, x, y) (BODY_WORD(body, x, y) ^= BODY_BIT(x))
+#define BODY_ROW_GET(row, x) (((row)[(size_t)((x) + BODY_WORD_BITS) / BODY_WORD_BITS - 1] >> \
+		((size_t)((x) + BODY_WORD_BITS) % BODY_WORD_BITS)) & 1) /* x may be in the left halo word */
+#define BODY_ROW_SET(row, x) ((row)[(size_t)((x) + BODY_WORD_BITS) / BODY_WORD_BITS - 1] |= BODY_BIT((x) + BODY_WORD_BITS))
+#define BODY_TAIL_MASK(body) (~(uint64_t)0 >> (((body)->words * BODY_WORD_BITS - (body)->cols) % BODY_WORD_BITS))
+
+/*
+ * Generations rules keep the decay of dying cells in bit planes laid out
+ * 	like the cells and following them, plane p holds bit p of the decay.
+ * 	The halo of the planes stays clear.
+ */
+#define BODY_PLANE_ROW(body, p, y) (BODY_ROW(body, y) + ((ptrdiff_t)(p) + 1) * (ptrdiff_t)(body)->plane_size)
 
 struct cell_meta_data {
 	int rows;
@@ -26,34 +64,140 @@ struct cell_meta_data {
 	int color_g;
 	int color_b;
 	int alive_prob;
+	int topology;
 };
 extern struct cell_meta_data cell_meta;
 
-typedef struct cell_s cell_t;
-struct cell_s {
-	SDL_Rect rect;
-	uint8_t alive;
+/*
+ * The body is divided in tiles, only tiles near a change are recomputed.
+ * 	The size of the tiles is set at startup, or tuned to the caches when
+ * 	left at 0, see tile_tune.
+ */
+#define TILE_ROWS_DEFAULT 0
+#define TILE_WORDS_DEFAULT 0
+#define TILE_GENERATIONS_DEFAULT 1
+#define TILE_GENERATIONS_MAX 64
+#define TILE_ROWS_MAX 4096
+#define TILE_WORDS_MAX 64
+#define TILE_ROWS_TUNED_MAX 256 /* tuned tiles stay small enough to sleep and to share among threads */
+#define TILE_WORDS_TUNED_MAX 16
+#define TILE_L1_DEFAULT (32 * 1024) /* cache sizes when the system does not report them */
+#define TILE_L2_DEFAULT (256 * 1024)
+
+struct tile_meta_data {
+	int rows; /* rows of a tile */
+	int words; /* words of a tile row */
+	int generations; /* generations per pass over the body, see compute_generations */
+};
+extern struct tile_meta_data tile_meta;
+
+typedef struct tile_s tile_t;
+struct tile_s {
+	uint32_t pop; /* population of the tile */
+	uint8_t changed; /* the tile differs from the previous generation */
+};
+
+typedef struct span_s span_t;
+struct span_s {
+	size_t row_start;
+	size_t row_end;
+	size_t word_start;
+	size_t word_end;
 };
 
 typedef struct body_s body_t;
 struct body_s {
 	size_t rows;
 	size_t cols;
-	cell_t **cells;
+	size_t words; /* words per row */
+	size_t stride; /* words per row including the halo */
+	size_t halo; /* halo rows on either side, and halo cells in the halo words */
+	uint64_t *cells; /* (rows + 2 * halo) * stride bit-packed cells, row-major */
+	size_t planes; /* decay planes of a Generations rule */
+	size_t plane_size; /* (rows + 2 * halo) * stride */
+	size_t tile_height; /* rows of a tile */
+	size_t tile_words; /* words of a tile row */
+	size_t tile_rows;
+	size_t tile_cols;
+	tile_t *tiles; /* tile_rows * tile_cols, row-major */
+	uint32_t *queue; /* tile_rows * tile_cols, the active tiles handed out, see compute_steal */
+};
+
+/* Edges of the body that hold a changed tile, see tile_edges */
+#define EDGE_TOP 0x1
+#define EDGE_BOTTOM 0x2
+#define EDGE_LEFT 0x4
+#define EDGE_RIGHT 0x8
+
+struct wave_progress {
+	size_t tile_rows; /* tile rows finished */
+} __attribute__((aligned(64))); /* One cache line per thread */
+
+struct wavefront_job {
+	body_t **bodies; /* generation i of the wavefront in bodies[i], one per thread */
+	struct wave_progress *progress; /* one per thread */
+};
+
+struct pass_job {
+	body_t *body_new;
+	const body_t *body_old;
+	size_t generations; /* generations per pass */
+	size_t band; /* rows of a band, a multiple of the tile rows */
+};
+
+/*
+ * The active tiles of a generation are queued in body->queue, each thread
+ * 	queueing the ones of its band. A thread takes tiles from the end of
+ * 	its queue and, once it is empty, steals the first half of another.
+ */
+struct tile_queue {
+	uint64_t range; /* first << 32 | end, the slots of body->queue left */
+} __attribute__((aligned(64))); /* One cache line per thread */
+
+struct generation_job {
+	body_t *body_new;
+	const body_t *body_old;
+	unsigned edges; /* changed edges seen through the wrapped halo */
+	size_t ready; /* threads that have filled their queue */
 };
 
-static cell_t *cell_init(size_t width, size_t height);
 body_t *body_init(size_t rows, size_t cols);
-static void cell_destroy(cell_t *cell);
 void body_destory(body_t *body);
+void body_clear(body_t *body);
+void body_copy(body_t *dst, const body_t *src);
+uint64_t body_population(const body_t *body);
+int body_state(const body_t *body, size_t x, size_t y);
+static uint64_t bit_reverse(uint64_t word);
+static void row_reverse(const body_t *body, uint64_t *dst, const uint64_t *src);
+static void row_fill_halo(const body_t *body, uint64_t *row, const uint64_t *src);
+void body_fill_halo(body_t *body);
+int topology_find(const char *name);
+void topology_print_choices(void);
+int topology_get(const body_t *body, ptrdiff_t x, ptrdiff_t y);
 
-static void draw_cell(SDL_Renderer *renderer, cell_t *cell, int x, int y);
-void draw_generation(SDL_Renderer *renderer, body_t *body);
-static body_t *random_mode(body_t *body, int *pop);
-static body_t *pattern_mode(body_t *body, int *pop);
-static body_t *drawing_mode(SDL_Renderer *renderer, body_t *body, int *pop);
-body_t *inital_generation(SDL_Renderer *renderer, body_t *body, int *pop);
-void compute_generation(body_t *body, body_t *body_old, int *pop);
-void export_body(body_t *body, int generation, int population);
+static void *random_mode(void *state);
+static void *pattern_mode(void *state);
+void *inital_generation(void *state, uint64_t *pop);
+static long cache_size(int name, long fallback);
+void tile_tune(void);
+static void tile_span(const body_t *body, size_t tile_row, size_t tile_col, span_t *span);
+static unsigned tile_near_edges(const body_t *body, size_t tile_row, size_t tile_col);
+static unsigned tile_edges(const body_t *body);
+static int tile_active(const body_t *body, size_t tile_row, size_t tile_col, unsigned edges);
+static uint64_t tile_compute(body_t *body_new, const body_t *body_old, size_t tile_row, size_t tile_col);
+static uint64_t tile_sleep(body_t *body_new, const body_t *body_old, size_t tile_row, size_t tile_col, int copy);
+static uint64_t compute_tile(body_t *body_new, const body_t *body_old, size_t tile_row, size_t tile_col,
+		unsigned edges, int copy);
+static int tile_queue_pop(struct tile_queue *queue, uint32_t *slot);
+static int tile_queue_steal(struct tile_queue *victim, struct tile_queue *thief);
+static uint64_t compute_steal(void *arg, size_t id, size_t threads);
+void compute_generation(body_t *body, body_t *body_old, uint64_t *pop);
+static uint64_t compute_wave(void *arg, size_t id, size_t threads);
+void compute_wavefront(body_t **bodies, uint64_t *pop);
+static void pass_load(body_t *scratch, const body_t *body, ptrdiff_t first, size_t rows);
+static uint64_t compute_pass(void *arg, size_t id, size_t threads);
+void compute_generations(body_t *body_new, body_t *body_old, size_t generations, uint64_t *pop);
+void compute_generations_destroy(void);
+void export_body(body_t *body, uint64_t generation);
 
 #endif /* _CELL_H_ */
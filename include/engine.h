@@ -0,0 +1,74 @@
+#ifndef _ENGINE_H_
+#define _ENGINE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "cell.h"
+#include "pool.h"
+
+#define ENGINE_DEFAULT "reference"
+
+/*
+ * A simulation engine. The driver only talks to the engine through these
+ * 	functions, the engine keeps its universe in the state returned by
+ * 	init and the body is only used to load and read cells. The initial
+ * 	generation is seeded cell by cell with set, so an engine that does
+ * 	not store the whole body never needs one to start.
+ */
+typedef struct engine_s engine_t;
+struct engine_s {
+	const char *name;
+	int unbounded; /* cells leaving the body keep evolving, no topology */
+	unsigned step_log_max; /* largest step is 2^step_log_max generations */
+	unsigned rules; /* RULE_FAMILY_* the engine runs */
+	void *(*init)(size_t rows, size_t cols);
+	void (*load)(void *state, const body_t *body);
+	void (*set)(void *state, size_t x, size_t y); /* make a cell of the region covered by the body alive */
+	void (*step)(void *state, uint64_t generations);
+	uint64_t (*population)(void *state);
+	void (*read)(void *state, body_t *body); /* the region covered by the body, tiles changed since the last read marked */
+	void (*destroy)(void *state);
+};
+extern const engine_t *engine;
+
+/*
+ * The tile engine, a ping-pong pair of bodies computed by the kernels and
+ * 	the spare bodies the generations of a wavefront pass through.
+ */
+typedef struct reference_s reference_t;
+struct reference_s {
+	body_t *body;
+	body_t *body_old;
+	body_t *spare[POOL_MAX_THREADS - 1];
+	uint8_t *changed; /* tiles changed in any generation since the last read */
+	uint64_t pop;
+};
+
+static void *reference_init(size_t rows, size_t cols);
+static void reference_load(void *state, const body_t *body);
+static void reference_set(void *state, size_t x, size_t y);
+static void reference_wavefront(reference_t *ref);
+static void reference_changed(reference_t *ref, const body_t *body);
+static void reference_step(void *state, uint64_t generations);
+static uint64_t reference_population(void *state);
+static void reference_read(void *state, body_t *body);
+static void reference_destroy(void *state);
+static void *hashlife_engine_init(size_t rows, size_t cols);
+static void hashlife_engine_load(void *state, const body_t *body);
+static void hashlife_engine_set(void *state, size_t x, size_t y);
+static void hashlife_engine_step(void *state, uint64_t generations);
+static uint64_t hashlife_engine_population(void *state);
+static void hashlife_engine_read(void *state, body_t *body);
+static void hashlife_engine_destroy(void *state);
+static void *sparse_engine_init(size_t rows, size_t cols);
+static void sparse_engine_load(void *state, const body_t *body);
+static void sparse_engine_set(void *state, size_t x, size_t y);
+static void sparse_engine_step(void *state, uint64_t generations);
+static uint64_t sparse_engine_population(void *state);
+static void sparse_engine_read(void *state, body_t *body);
+static void sparse_engine_destroy(void *state);
+const engine_t *engine_find(const char *name);
+void engine_print_choices(void);
+
+#endif /* _ENGINE_H_ */
@@ -0,0 +1,72 @@
+#ifndef _HASHLIFE_H_
+#define _HASHLIFE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "cell.h"
+
+#define HASHLIFE_CACHE_MB_DEFAULT 256
+#define HASHLIFE_MAX_LEVEL 62
+#define HASHLIFE_STEP_LOG_MAX 48
+#define HASHLIFE_CHUNK_NODES 4096
+
+struct hashlife_meta_data {
+	int cache_mb;
+};
+extern struct hashlife_meta_data hashlife_meta;
+
+/*
+ * A quadtree node covering a 2^level square. Nodes are canonical, two
+ * 	nodes with the same children are the same node, so a node can be
+ * 	compared and hashed by its children's addresses.
+ */
+typedef struct hl_node_s hl_node_t;
+struct hl_node_s {
+	hl_node_t *nw, *ne, *sw, *se; /* NULL for a single cell */
+	hl_node_t *next; /* next node in the hash chain or the free list */
+	hl_node_t *result; /* memoized RESULT, 2^result_log generations ahead */
+	uint64_t pop;
+	uint32_t level;
+	uint16_t mark;
+	uint16_t result_log;
+};
+
+typedef struct hashlife_s hashlife_t;
+struct hashlife_s {
+	hl_node_t **table;
+	size_t buckets; /* power of two */
+	size_t nodes; /* nodes in the table */
+	size_t max_nodes; /* garbage collect above this many nodes between steps, a soft limit */
+	hl_node_t *free_list;
+	hl_node_t **chunks;
+	size_t chunk_count;
+	hl_node_t leaf[2]; /* the dead and the alive cell */
+	hl_node_t *empty[HASHLIFE_MAX_LEVEL + 1];
+	hl_node_t *root; /* centered on the origin */
+	unsigned step_log; /* nodes advance min(2^(level - 2), 2^step_log) generations */
+};
+
+hashlife_t *hashlife_init(size_t cache_mb);
+void hashlife_destroy(hashlife_t *hl);
+static hl_node_t *node_alloc(hashlife_t *hl);
+static hl_node_t *node_find(hashlife_t *hl, hl_node_t *nw, hl_node_t *ne, hl_node_t *sw, hl_node_t *se);
+static hl_node_t *node_empty(hashlife_t *hl, uint32_t level);
+static void node_mark(hl_node_t *node);
+static void hashlife_gc(hashlife_t *hl);
+static unsigned hashlife_result_log(hashlife_t *hl, hl_node_t *node);
+static hl_node_t *hashlife_base(hashlife_t *hl, hl_node_t *node);
+static hl_node_t *hashlife_result(hashlife_t *hl, hl_node_t *node);
+static hl_node_t *hashlife_expand(hashlife_t *hl, hl_node_t *node);
+static void hashlife_grow(hashlife_t *hl);
+static int hashlife_centered(hl_node_t *node);
+static hl_node_t *hashlife_build(hashlife_t *hl, const body_t *body, uint32_t level, int64_t x0, int64_t y0);
+static void hashlife_write(hl_node_t *node, body_t *body, int64_t x0, int64_t y0);
+void hashlife_load(hashlife_t *hl, const body_t *body);
+static hl_node_t *node_set(hashlife_t *hl, hl_node_t *node, int64_t x, int64_t y);
+void hashlife_set(hashlife_t *hl, int64_t x, int64_t y);
+void hashlife_step(hashlife_t *hl, unsigned step_log);
+void hashlife_read(hashlife_t *hl, body_t *body);
+uint64_t hashlife_population(hashlife_t *hl);
+
+#endif /* _HASHLIFE_H_ */
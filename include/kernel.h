@@ -0,0 +1,66 @@
+#ifndef _KERNEL_H_
+#define _KERNEL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "cell.h"
+#include "rule.h"
+
+#define KERNEL_DEFAULT "auto"
+#define LUT_ENTRIES 65536 /* every 4x4 block */
+#define ISOTROPIC_ENTRIES 512 /* every 3x3 block */
+#define LTL_SUMS_MAX (TILE_WORDS_MAX * BODY_WORD_BITS + 2 * RULE_RADIUS_MAX) /* column sums of a span */
+
+typedef struct kernel_s kernel_t;
+struct kernel_s {
+	const char *name;
+	int (*supported)(void);
+	void (*init)(void); /* prepares the kernel once it is selected, may be NULL */
+	uint64_t (*compute)(body_t *body_new, const body_t *body_old, const span_t *span, int *changed);
+	unsigned rules; /* RULE_FAMILY_* the kernel runs */
+};
+
+/* Computes a run of words of one row, see compute_words */
+typedef void (*rule_words_t)(uint64_t *out, const uint64_t *above, const uint64_t *row,
+		const uint64_t *below, size_t start, size_t end);
+extern const kernel_t *kernel;
+
+static inline uint64_t compute_word(uint64_t aw, uint64_t a, uint64_t ae,
+		uint64_t w, uint64_t c, uint64_t e, uint64_t bw, uint64_t b, uint64_t be);
+static void compute_words(uint64_t *out, const uint64_t *above, const uint64_t *row,
+		const uint64_t *below, size_t start, size_t end);
+static inline uint64_t finish_row(const body_t *body, uint64_t *out, const uint64_t *row,
+		size_t start, size_t end, uint64_t *diff);
+static uint64_t scalar_compute(body_t *body_new, const body_t *body_old, const span_t *span, int *changed);
+static inline void count_word(uint64_t aw, uint64_t a, uint64_t ae,
+		uint64_t w, uint64_t e, uint64_t bw, uint64_t b, uint64_t be, uint64_t count[4]);
+static inline uint64_t count_match(const uint64_t count[4], uint16_t counts);
+static inline uint64_t rule_word(uint64_t aw, uint64_t a, uint64_t ae,
+		uint64_t w, uint64_t c, uint64_t e, uint64_t bw, uint64_t b, uint64_t be,
+		uint16_t birth, uint16_t survive);
+static inline void rule_words(uint64_t *out, const uint64_t *above,
+		const uint64_t *row, const uint64_t *below, size_t start, size_t end,
+		uint16_t birth, uint16_t survive);
+static void generic_words(uint64_t *out, const uint64_t *above, const uint64_t *row,
+		const uint64_t *below, size_t start, size_t end);
+static void rule_init(void);
+static uint64_t rule_compute(body_t *body_new, const body_t *body_old, const span_t *span, int *changed);
+static inline uint64_t generations_span(body_t *body_new,
+		const body_t *body_old, const span_t *span, int *changed,
+		uint16_t birth, uint16_t survive, uint16_t states, size_t planes);
+static uint64_t generations_generic(body_t *body_new, const body_t *body_old, const span_t *span, int *changed);
+static void generations_init(void);
+static uint64_t generations_compute(body_t *body_new, const body_t *body_old, const span_t *span, int *changed);
+static uint64_t ltl_compute(body_t *body_new, const body_t *body_old, const span_t *span, int *changed);
+static uint64_t colsum_compute(body_t *body_new, const body_t *body_old, const span_t *span, int *changed);
+static void isotropic_init(void);
+static uint64_t isotropic_compute(body_t *body_new, const body_t *body_old, const span_t *span, int *changed);
+static void lut_init(void);
+static uint64_t lut_compute(body_t *body_new, const body_t *body_old, const span_t *span, int *changed);
+static uint64_t naive_compute(body_t *body_new, const body_t *body_old, const span_t *span, int *changed);
+const kernel_t *kernel_find(const char *name);
+const kernel_t *kernel_best(void);
+void kernel_print_choices(void);
+
+#endif /* _KERNEL_H_ */
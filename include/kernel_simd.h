@@ -0,0 +1,77 @@
+/*
+ * Template for the vectorized generation kernels. src/kernel.c includes this
+ * 	file once per instruction set after defining:
+ *
+ * SIMD_NAME: name of the generated compute function.
+ * SIMD_TARGET: the target attribute the function is compiled for.
+ * SIMD_LANES: number of 64-bit words processed per vector.
+ *
+ * Words are loaded together with the vectors one word to their west and
+ * 	east, so no shuffling is needed to carry bits between words. The halo
+ * 	around the body makes those loads valid at the edges. Words left over
+ * 	at the end of a span go through the scalar path.
+ */
+
+__attribute__((target(SIMD_TARGET)))
+static uint64_t SIMD_NAME(body_t *body_new, const body_t *body_old, const span_t *span, int *changed)
+{
+	typedef uint64_t vec_t __attribute__((vector_size(SIMD_LANES * sizeof(uint64_t))));
+	size_t y, i;
+	const uint64_t *above, *row, *below;
+	uint64_t *out, pop = 0, diff = 0;
+	vec_t n[3], c[3], s[3], aw, ae, w, e, bw, be;
+	vec_t a0, a1, b0, b1, m0, m1, s0, s1, x, xa, z, za;
+
+#define SIMD_LOAD3(dst, src) do { \
+		__builtin_memcpy(&dst[0], (src) + i - 1, sizeof(vec_t)); \
+		__builtin_memcpy(&dst[1], (src) + i, sizeof(vec_t)); \
+		__builtin_memcpy(&dst[2], (src) + i + 1, sizeof(vec_t)); \
+	} while (0)
+#define SIMD_WEST(v) ((v[1] << 1) | (v[0] >> (BODY_WORD_BITS - 1)))
+#define SIMD_EAST(v) ((v[1] >> 1) | (v[2] << (BODY_WORD_BITS - 1)))
+
+	for (y=span->row_start; y < span->row_end; y++) {
+		above = BODY_ROW(body_old, y - 1);
+		row = BODY_ROW(body_old, y);
+		below = BODY_ROW(body_old, y + 1);
+		out = BODY_ROW(body_new, y);
+
+		for (i=span->word_start; i + SIMD_LANES <= span->word_end; i += SIMD_LANES) {
+			SIMD_LOAD3(n, above);
+			SIMD_LOAD3(c, row);
+			SIMD_LOAD3(s, below);
+			aw = SIMD_WEST(n);
+			ae = SIMD_EAST(n);
+			w = SIMD_WEST(c);
+			e = SIMD_EAST(c);
+			bw = SIMD_WEST(s);
+			be = SIMD_EAST(s);
+
+			/* Same adder network as compute_word */
+			a0 = aw ^ n[1] ^ ae;
+			a1 = (aw & n[1]) | (ae & (aw ^ n[1]));
+			b0 = bw ^ s[1] ^ be;
+			b1 = (bw & s[1]) | (be & (bw ^ s[1]));
+			m0 = w ^ e;
+			m1 = w & e;
+			s0 = a0 ^ b0 ^ m0;
+			s1 = (a0 & b0) | (m0 & (a0 ^ b0));
+			x = a1 ^ b1;
+			xa = a1 & b1;
+			z = m1 ^ s1;
+			za = m1 & s1;
+			z = (x ^ z) & ~(xa | za) & (s0 | c[1]);
+
+			__builtin_memcpy(out + i, &z, sizeof(vec_t));
+		}
+		compute_words(out, above, row, below, i, span->word_end);
+		pop += finish_row(body_old, out, row, span->word_start, span->word_end, &diff);
+	}
+
+#undef SIMD_LOAD3
+#undef SIMD_WEST
+#undef SIMD_EAST
+
+	*changed = diff != 0;
+	return pop;
+}
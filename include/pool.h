@@ -0,0 +1,44 @@
+#ifndef _POOL_H_
+#define _POOL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#define THREADS_DEFAULT 1
+#define POOL_MAX_THREADS 256
+
+/*
+ * A job is run by every thread of the pool, id is in [0, threads). The
+ * value returned by each thread is summed by pool_run.
+ */
+typedef uint64_t (*pool_job_t)(void *arg, size_t id, size_t threads);
+
+struct pool_slot {
+	uint64_t result;
+} __attribute__((aligned(64))); /* One cache line per thread */
+
+typedef struct pool_s pool_t;
+struct pool_s {
+	size_t threads;
+	pthread_t *workers;
+	pthread_barrier_t start;
+	pthread_barrier_t done;
+	pool_job_t job;
+	void *arg;
+	int quit;
+	struct pool_slot *slots;
+};
+extern pool_t *pool;
+
+struct pool_worker_arg {
+	pool_t *pool;
+	size_t id;
+};
+
+pool_t *pool_init(size_t threads);
+void pool_destroy(pool_t *pool);
+static void *pool_worker(void *arg);
+uint64_t pool_run(pool_t *pool, pool_job_t job, void *arg);
+
+#endif /* _POOL_H_ */
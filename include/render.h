@@ -0,0 +1,43 @@
+#ifndef _RENDER_H_
+#define _RENDER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <SDL.h>
+#include <SDL_ttf.h>
+
+#include "cell.h"
+
+#define RENDER_DELAY 10 /* milliseconds the window waits when no new generation is ready */
+#define DRAW_BLOCK_ROWS 8 /* rows of the blocks of cells of a changed tile redrawn when they differ, one word wide */
+
+#define STAT_FONT_SIZE 18
+#define GLYPH_FIRST ' ' /* the printable characters have a glyph */
+#define GLYPH_LAST '~'
+#define GLYPH_COUNT (GLYPH_LAST - GLYPH_FIRST + 1)
+#define TEXT_ATLAS_MAX 4 /* font sizes in use */
+
+struct glyph_atlas {
+	int font_size;
+	SDL_Texture *texture; /* white glyphs side by side, tinted when drawn */
+	SDL_Rect glyphs[GLYPH_COUNT]; /* place of each glyph in the texture */
+};
+
+static void draw_palette(uint32_t *palette);
+static void draw_grid(SDL_Renderer *renderer, const body_t *body);
+static int draw_block(const body_t *body, const uint32_t *palette, size_t y_start, size_t y_end,
+		size_t word, int full);
+void draw_generation(SDL_Renderer *renderer, body_t *body);
+void draw_destroy(void);
+body_t *drawing_mode(SDL_Renderer *renderer, body_t *body, uint64_t *pop);
+static TTF_Font *text_font(int font_size);
+static struct glyph_atlas *text_atlas(SDL_Renderer *renderer, int font_size);
+void text_init(SDL_Renderer *renderer);
+void text_destroy(void);
+void display_text(SDL_Renderer *renderer, char *text, SDL_Color color, int font_size, int x, int y, int w, int h);
+void display_body_statistics(SDL_Renderer *renderer, uint64_t gen, uint64_t pop);
+void run_window(void);
+
+#define DISPLAY_STAT(renderer, text, color, height) display_text(renderer, text, color, STAT_FONT_SIZE, 25, height, 0, 0);
+
+#endif /* _RENDER_H_ */
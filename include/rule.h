@@ -0,0 +1,67 @@
+#ifndef _RULE_H_
+#define _RULE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define RULE_DEFAULT "B3/S23"
+
+#define RULE_STATES_MAX 256
+#define RULE_PLANES_MAX 8 /* decay planes of RULE_STATES_MAX states */
+#define RULE_RADIUS_MAX 16 /* within a tile and a halo word */
+#define RULE_CASES 256 /* arrangements of the 8 neighbors */
+
+/*
+ * An outer-totalistic rule. Bit n of birth is set when a dead cell with n
+ * 	alive neighbors is born, bit n of survive when an alive cell with n
+ * 	alive neighbors survives. Generations rules have more than two
+ * 	states, an alive cell that does not survive decays through states 2
+ * 	to states - 1 before it is dead, only alive cells are neighbors.
+ * 	Larger than Life rules count the alive cells within radius cells
+ * 	instead, a cell is born or survives when its count is in a range.
+ * 	Isotropic non-totalistic rules tell apart the arrangements of the
+ * 	neighbors, bit n of birth_cases and survive_cases is set when the
+ * 	neighbors n are born or survive, bit i of n being neighbor i in
+ * 	N, NE, E, SE, S, SW, W, NW order.
+ */
+typedef struct rule_s rule_t;
+struct rule_s {
+	uint16_t birth;
+	uint16_t survive;
+	uint16_t states; /* 2 unless a Generations rule */
+	uint16_t radius; /* 1 unless a Larger than Life rule */
+	uint8_t ltl; /* Larger than Life, the counts below replace birth and survive */
+	uint8_t middle; /* Larger than Life counts the cell itself */
+	uint16_t birth_min, birth_max;
+	uint16_t survive_min, survive_max;
+	uint8_t isotropic; /* the cases below replace birth and survive */
+	uint64_t birth_cases[RULE_CASES / 64];
+	uint64_t survive_cases[RULE_CASES / 64];
+};
+extern rule_t rule;
+
+/* Families of rules, kernels and engines list the families they run */
+#define RULE_FAMILY_CONWAY 0x1 /* B3/S23 */
+#define RULE_FAMILY_TOTALISTIC 0x2 /* any other two-state rule */
+#define RULE_FAMILY_GENERATIONS 0x4
+#define RULE_FAMILY_LTL 0x8 /* Larger than Life */
+#define RULE_FAMILY_ISOTROPIC 0x10 /* isotropic non-totalistic, Hensel notation */
+
+#define RULE_N(n) (1 << (n))
+#define RULE_CONWAY_BIRTH RULE_N(3)
+#define RULE_CONWAY_SURVIVE (RULE_N(2) | RULE_N(3))
+#define RULE_IS_CONWAY(r) ((r).birth == RULE_CONWAY_BIRTH && (r).survive == RULE_CONWAY_SURVIVE)
+#define RULE_NEXT(r, alive, neighbors) (((alive) ? (r).survive : (r).birth) >> (neighbors) & 1)
+#define RULE_CASE(cases, n) ((cases)[(n) / 64] >> ((n) % 64) & 1)
+#define RULE_NEXT_CASE(r, alive, n) RULE_CASE((alive) ? (r).survive_cases : (r).birth_cases, n)
+
+static void rule_count_cases(int count, uint64_t cases[RULE_CASES / 64]);
+static int rule_letter_cases(int count, char letter, uint64_t cases[RULE_CASES / 64]);
+static int rule_cases_totalistic(const uint64_t cases[RULE_CASES / 64]);
+static int rule_parse_counts(const char *str, uint16_t *counts, uint64_t cases[RULE_CASES / 64]);
+static int rule_parse_ltl(const char *str, rule_t *rule);
+int rule_parse(const char *str, rule_t *rule);
+unsigned rule_family(const rule_t *rule);
+size_t rule_planes(const rule_t *rule);
+
+#endif /* _RULE_H_ */
@@ -0,0 +1,67 @@
+#ifndef _SIMULATION_H_
+#define _SIMULATION_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#include "cell.h"
+
+#define SIMULATION_POLL_MS 10 /* longest sleep before the simulation checks for a pause or quit */
+
+/* A generation handed from the simulation to the window */
+typedef struct frame_s frame_t;
+struct frame_s {
+	body_t *body;
+	uint64_t generation;
+	uint64_t population;
+};
+
+/*
+ * A lock-free triple buffer. The simulation fills the back frame and the
+ * 	window shows the front frame, each swaps its frame with the middle
+ * 	one in a single atomic exchange, so neither waits for the other.
+ * 	TRIPLE_FRESH marks a middle frame the window has not taken yet.
+ */
+#define TRIPLE_FRAMES 3
+#define TRIPLE_INDEX 0x3
+#define TRIPLE_FRESH 0x4
+
+typedef struct triple_s triple_t;
+struct triple_s {
+	frame_t frames[TRIPLE_FRAMES];
+	unsigned back; /* owned by the simulation */
+	unsigned middle; /* index of the middle frame | TRIPLE_FRESH, exchanged atomically */
+	unsigned front; /* owned by the window */
+};
+
+/*
+ * The simulation thread, stepping the engine at its own pace. The window
+ * 	only reads the frames and sets the controls, which are accessed
+ * 	atomically.
+ */
+typedef struct simulation_s simulation_t;
+struct simulation_s {
+	pthread_t thread;
+	void *state; /* the engine's state, owned by the thread once started */
+	triple_t triple;
+	uint64_t generation;
+	int pause;
+	int quit;
+	int step; /* pause after every step */
+	uint32_t delay; /* milliseconds between steps */
+	unsigned step_log; /* 2^step_log generations per step */
+	uint8_t *unseen; /* tiles changed since the last frame the window took, see simulation_run */
+};
+
+void triple_init(triple_t *triple, const body_t *body, uint64_t population);
+void triple_destroy(triple_t *triple);
+int triple_publish(triple_t *triple);
+frame_t *triple_front(triple_t *triple);
+static void simulation_sleep(simulation_t *sim, uint32_t ms);
+static void simulation_changed(simulation_t *sim, body_t *body);
+static void *simulation_run(void *arg);
+simulation_t *simulation_start(void *state, const body_t *body, uint64_t population, uint32_t delay);
+void simulation_stop(simulation_t *sim);
+
+#endif /* _SIMULATION_H_ */
@@ -0,0 +1,42 @@
+#ifndef _SPARSE_H_
+#define _SPARSE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "cell.h"
+
+#define SPARSE_TALLY_ALIVE 0x10 /* the tallied cell is alive */
+#define SPARSE_TALLY_COUNT 0x0F /* neighbor count of the tallied cell */
+#define SPARSE_KEY(x, y) (((uint64_t)(uint32_t)(y) << 32) | (uint32_t)(x))
+#define SPARSE_KEY_X(key) ((int32_t)(uint32_t)(key))
+#define SPARSE_KEY_Y(key) ((int32_t)(uint32_t)((key) >> 32))
+
+/*
+ * A universe storing only its live cells. Coordinates are 32 bit, the
+ * 	universe is 2^32 cells on a side.
+ */
+typedef struct sparse_s sparse_t;
+struct sparse_s {
+	uint64_t *live; /* keys of the live cells */
+	size_t count;
+	size_t capacity;
+	uint64_t *tally_keys; /* open-addressing table of tallied cells */
+	uint8_t *tally_counts; /* 0 marks an empty slot */
+	size_t tally_capacity; /* power of two */
+	int duplicates; /* live may hold a cell more than once, see sparse_unique */
+};
+
+sparse_t *sparse_init(void);
+void sparse_destroy(sparse_t *sp);
+static void sparse_push(sparse_t *sp, uint64_t key);
+static void sparse_tally(sparse_t *sp, uint64_t key, uint8_t amount);
+void sparse_load(sparse_t *sp, const body_t *body);
+void sparse_set(sparse_t *sp, int32_t x, int32_t y);
+static int sparse_compare(const void *a, const void *b);
+static void sparse_unique(sparse_t *sp);
+void sparse_step(sparse_t *sp);
+void sparse_read(sparse_t *sp, body_t *body);
+uint64_t sparse_population(sparse_t *sp);
+
+#endif /* _SPARSE_H_ */
@@ -1,9 +1,13 @@
 #ifndef _UTILITIES_H_
 #define _UTILITIES_H_
 
-#include <SDL.h>
+#include <stdint.h>
+
+#include "cell.h"
 
 #define DELAY_DEFAULT 1000
+#define STEP_LOG_MAX 16
+#define OPTION_HEADLESS 256 /* --headless, past the characters of the short options */
 #define WINDOW_WIDTH 800
 #define WINDOW_HEIGHT 800
 #define MAX_WINDOW_WIDTH 1000
@@ -18,6 +22,10 @@
 extern char *proj_dir;
 extern char mode;
 extern int step;
+extern uint64_t benchmark; /* generations of the benchmark, 0 to open the window */
+extern uint64_t headless; /* generations run without a window, 0 to open the window */
+extern int threads;
+extern int wavefront; /* the threads pipeline generations instead of splitting them */
 
 struct background_meta_data {
 	int width;
@@ -34,9 +42,9 @@ static void print_usage(void);
 static void print_patterns(char *pattern_choices[]);
 char *parse_pattern_choice(void);
 void parse_input(int argc, char *argv[]);
-void display_text(SDL_Renderer *renderer, char *text, SDL_Color color, int font_size, int x, int y, int w, int h);
-void display_body_statistics(SDL_Renderer *renderer, int gen, int pop);
-
-#define DISPLAY_STAT(renderer, text, color, height) display_text(renderer, text, color, 18, 25, height, 0, 0);
+static void benchmark_fill(void *state);
+static void run_batch(void *state, uint64_t generations);
+void run_benchmark(uint64_t generations);
+void run_headless(uint64_t generations);
 
 #endif /* _UTILITIES_H_ */
@@ -1,42 +1,28 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <limits.h>
 #include <time.h>
-#include <SDL.h>
-#include <SDL_ttf.h>
+#include <unistd.h>
+#include <sched.h>
+#include <inttypes.h>
 
 #include "cell.h"
 #include "utilities.h"
-
-/*
- * Function:	cell_init
- * ----------------------
- * Initialize a unique cell.
- *
- * width: width of the cell in pixels.
- * height: height of the cell in pixels.
- *
- * returns: pointer to the newly allocated cell.
- */
-static cell_t *cell_init(size_t width, size_t height)
-{
-	cell_t *cell_new = malloc(sizeof(*cell_new));
-	if (!cell_new) {
-		perror("cell_init: Failed to malloc cell_new");
-		exit(EXIT_FAILURE);
-	}
-
-	cell_new->rect.w = width;
-	cell_new->rect.h = height;
-	cell_new->alive = 0;
-
-	return cell_new;
-}
+#include "kernel.h"
+#include "pool.h"
+#include "rule.h"
+#include "engine.h"
 
 /*
  * Function:	body_init
  * ----------------------
- * Initialize a body of cells.
+ * Initialize a body of cells. The body, its tiles, and its cells share a
+ * 	single cache line aligned allocation, the cells are bit-packed
+ * 	row-major and surrounded by a halo of dead cells as wide as the
+ * 	selected rule's radius, followed by the decay planes the rule needs. Every tile starts out changed so
+ * 	the first generation is computed in full.
  *
  * rows: number of rows in the body.
  * cols: number of cols in the body.
@@ -45,9 +31,23 @@ static cell_t *cell_init(size_t width, size_t height)
  */
 body_t *body_init(size_t rows, size_t cols)
 {
-	size_t x, y;
+	size_t i;
+	size_t header_size = BODY_ROUND_UP(sizeof(body_t));
+	size_t words = (cols + BODY_WORD_BITS - 1) / BODY_WORD_BITS;
+	size_t tile_height, tile_rows, tile_cols, tiles_size, queue_size;
+	size_t halo = rule.radius;
+	size_t planes = rule_planes(&rule);
+	size_t cells_size = BODY_ROUND_UP((planes + 1) * (rows + 2 * halo) * (words + 2) * sizeof(uint64_t));
+	body_t *body_new;
 
-	body_t *body_new = malloc(sizeof(*body_new));
+	tile_tune();
+	tile_height = (size_t)tile_meta.rows > halo ? (size_t)tile_meta.rows : halo; /* see tile_active */
+	tile_rows = (rows + tile_height - 1) / tile_height;
+	tile_cols = (words + tile_meta.words - 1) / tile_meta.words;
+	tiles_size = BODY_ROUND_UP(tile_rows * tile_cols * sizeof(tile_t));
+	queue_size = BODY_ROUND_UP(tile_rows * tile_cols * sizeof(uint32_t));
+
+	body_new = aligned_alloc(BODY_ALIGNMENT, header_size + tiles_size + queue_size + cells_size);
 	if (!body_new) {
 		perror("body_init: Failed to malloc body_new");
 		exit(EXIT_FAILURE);
@@ -55,95 +55,320 @@ body_t *body_init(size_t rows, size_t cols)
 
 	body_new->rows = rows;
 	body_new->cols = cols;
+	body_new->words = words;
+	body_new->stride = words + 2;
+	body_new->halo = halo;
+	body_new->planes = planes;
+	body_new->plane_size = (rows + 2 * halo) * (words + 2);
+	body_new->tile_height = tile_height;
+	body_new->tile_words = tile_meta.words;
+	body_new->tile_rows = tile_rows;
+	body_new->tile_cols = tile_cols;
+	body_new->tiles = (tile_t *)((uint8_t *)body_new + header_size);
+	body_new->queue = (uint32_t *)((uint8_t *)body_new + header_size + tiles_size);
+	body_new->cells = (uint64_t *)((uint8_t *)body_new + header_size + tiles_size + queue_size);
+	memset(body_new->cells, 0, cells_size);
 
-	body_new->cells = malloc(body_new->rows * body_new->cols * sizeof(*body_new->cells));
-	if (!body_new->cells) {
-		perror("body_init: Failed to malloc body_new->cells");
-		exit(EXIT_FAILURE);
+	for (i=0; i < tile_rows * tile_cols; i++) {
+		body_new->tiles[i].pop = 0;
+		body_new->tiles[i].changed = 1;
 	}
 
-	for (x = 0; x < body_new->cols; x++)
-		for (y = 0; y < body_new->rows; y++)
-			body_new->cells[x * body_new->cols + y] = cell_init(cell_meta.width, cell_meta.height);
-
 	return body_new;
 }
 
 /*
- * Function:	cell_destroy
+ * Function:	body_destroy
  * -------------------------
- * Destroy a cell.
+ * Destroy a body.
  *
- * cell: pointer to the cell allocated in memory.
+ * body: pointer to the body allocated in memory.
  */
-static void cell_destroy(cell_t *cell)
+void body_destory(body_t *body)
 {
-	free(cell);
+	free(body);
 }
 
 /*
- * Function:	body_destroy
- * -------------------------
- * Destroy a body.
+ * Function:	body_clear
+ * -----------------------
+ * Kill every cell of a body, including its halo and decay planes.
  *
- * body: pointer to the body allocated in memory.
+ * body: the body being cleared.
  */
-void body_destory(body_t *body)
+void body_clear(body_t *body)
 {
-	size_t x, y;
-
-	for (x = 0; x < body->cols; x++)
-		for (y = 0; y < body->rows; y++)
-			cell_destroy(body->cells[x * body->cols + y]);
-	free(body->cells);
-	free(body);
+	memset(body->cells, 0, (body->planes + 1) * body->plane_size * sizeof(*body->cells));
 }
 
 /*
- * Function:	draw_cell
+ * Function:	body_copy
  * ----------------------
- * Draw a cell square.
+ * Copy the cells of a body into a body of the same size. Every tile of
+ * 	the copy is marked changed so its next generation is computed in full.
+ *
+ * dst: the body receiving the cells.
+ * src: the body holding the cells.
+ */
+void body_copy(body_t *dst, const body_t *src)
+{
+	size_t i;
+
+	memcpy(dst->cells, src->cells, (src->planes + 1) * src->plane_size * sizeof(*src->cells));
+	for (i=0; i < dst->tile_rows * dst->tile_cols; i++)
+		dst->tiles[i].changed = 1;
+}
+
+/*
+ * Function:	body_population
+ * ----------------------------
+ * Count the alive cells of a body, dying cells are not counted.
+ *
+ * body: the body being counted.
+ *
+ * returns: the number of alive cells.
+ */
+uint64_t body_population(const body_t *body)
+{
+	size_t y, i;
+	const uint64_t *row;
+	uint64_t pop = 0;
+
+	for (y=0; y < body->rows; y++) {
+		row = BODY_ROW(body, y);
+		for (i=0; i + 1 < body->words; i++)
+			pop += __builtin_popcountll(row[i]);
+		pop += __builtin_popcountll(row[body->words - 1] & BODY_TAIL_MASK(body));
+	}
+
+	return pop;
+}
+
+/*
+ * Function:	body_state
+ * -----------------------
+ * Get the state of a cell, reading its decay planes.
  *
- * renderer: SDL_Renderer struct used for rendering the cell square.
- * cell: cell stuct stores the location, width, and hight of the cell square.
+ * body: the body holding the cell.
  * x: the column of the cell.
  * y: the row of the cell.
+ *
+ * returns: 0 if the cell is dead, 1 if it is alive, 2 or more while it decays.
  */
-static void draw_cell(SDL_Renderer *renderer, cell_t *cell, int x, int y)
+int body_state(const body_t *body, size_t x, size_t y)
 {
-	cell->rect.x = cell_meta.width * x;
-	cell->rect.y = cell_meta.height * y;
-	cell->rect.w = cell_meta.width;
-	cell->rect.h = cell_meta.height;
+	size_t p;
+	int decay = 0;
+
+	if (BODY_GET(body, x, y))
+		return 1;
 
-	if (cell->alive)
-		SDL_SetRenderDrawColor(renderer, cell_meta.color_r, cell_meta.color_g, cell_meta.color_b, SDL_ALPHA_OPAQUE);
-	else
-		SDL_SetRenderDrawColor(renderer, bg_meta.color_r, bg_meta.color_g, bg_meta.color_b, SDL_ALPHA_OPAQUE);
+	for (p=0; p < body->planes; p++)
+		if (BODY_PLANE_ROW(body, p, y)[x / BODY_WORD_BITS] & BODY_BIT(x))
+			decay |= 1 << p;
 
-	SDL_RenderFillRect(renderer, &cell->rect);
+	return decay ? decay + 1 : 0;
+}
+
+static const char *topology_names[] = {
+	[TOPOLOGY_DEAD] = "dead",
+	[TOPOLOGY_TORUS] = "torus",
+	[TOPOLOGY_KLEIN] = "klein",
+	[TOPOLOGY_CROSS] = "cross",
+	NULL
+};
+
+/*
+ * Function:	bit_reverse
+ * ------------------------
+ * Reverse the order of the bits of a word.
+ *
+ * word: the word being reversed.
+ *
+ * returns: the reversed word.
+ */
+static uint64_t bit_reverse(uint64_t word)
+{
+	word = ((word >> 1) & 0x5555555555555555ULL) | ((word & 0x5555555555555555ULL) << 1);
+	word = ((word >> 2) & 0x3333333333333333ULL) | ((word & 0x3333333333333333ULL) << 2);
+	word = ((word >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((word & 0x0F0F0F0F0F0F0F0FULL) << 4);
+	return __builtin_bswap64(word);
+}
 
-	if (cell_meta.grid_on) {
-		SDL_SetRenderDrawColor(renderer, 215, 215, 215, SDL_ALPHA_OPAQUE);
-		SDL_RenderDrawRect(renderer, &cell->rect);
+/*
+ * Function:	row_reverse
+ * ------------------------
+ * Fill a halo row with a row flipped end to end, column x of dst holding
+ * 	column cols - 1 - x of src for x from -halo to cols + halo - 1, so
+ * 	the flip also swaps the halo cells of src.
+ *
+ * body: the body both rows belong to.
+ * dst: the halo row being filled.
+ * src: the row being flipped, its halo cells already filled.
+ */
+static void row_reverse(const body_t *body, uint64_t *dst, const uint64_t *src)
+{
+	size_t i, words = body->words;
+	size_t pad = words * BODY_WORD_BITS - body->cols;
+	ptrdiff_t x, cols = body->cols;
+
+	/* Reversing the words leaves the row shifted up by the padding bits */
+	for (i=0; i < words; i++) {
+		dst[i] = bit_reverse(src[words - 1 - i]) >> pad;
+		if (pad && i + 1 < words)
+			dst[i] |= bit_reverse(src[words - 2 - i]) << (BODY_WORD_BITS - pad);
+	}
+	dst[-1] = 0;
+	dst[words] = 0;
+
+	for (x=1; x <= (ptrdiff_t)body->halo; x++) {
+		if (BODY_ROW_GET(src, cols - 1 + x))
+			BODY_ROW_SET(dst, -x);
+		if (BODY_ROW_GET(src, -x))
+			BODY_ROW_SET(dst, cols - 1 + x);
 	}
 }
 
 /*
- * Function:	draw_generation
- * ----------------------------
- * Draw the current generation's cells.
+ * Function:	row_fill_halo
+ * --------------------------
+ * Fill the halo cells left and right of a row with the cells across the
+ * 	left and right edges, and clear the padding past the last cell.
  *
- * renderer: SDL_Renderer struct used for rendering the cell square.
- * body: the body containing the current generation of cells.
+ * body: the body the row belongs to.
+ * row: the row whose halo cells are filled.
+ * src: the row seen across the left and right edges, row itself unless
+ * 	the edges are flipped.
  */
-void draw_generation(SDL_Renderer *renderer, body_t *body)
+static void row_fill_halo(const body_t *body, uint64_t *row, const uint64_t *src)
 {
-	size_t x, y;
+	ptrdiff_t x, cols = body->cols;
 
-	for (x=0; x < body->cols; x++)
-		for (y=0; y < body->rows; y++)
-			draw_cell(renderer, body->cells[x * body->cols + y], x, y);
+	row[-1] = 0;
+	row[body->words - 1] &= BODY_TAIL_MASK(body);
+	row[body->words] = 0;
+
+	if (cell_meta.topology == TOPOLOGY_DEAD)
+		return;
+
+	for (x=1; x <= (ptrdiff_t)body->halo; x++) {
+		if (BODY_ROW_GET(src, cols - x))
+			BODY_ROW_SET(row, -x);
+		if (BODY_ROW_GET(src, x - 1))
+			BODY_ROW_SET(row, cols - 1 + x);
+	}
+}
+
+/*
+ * Function:	body_fill_halo
+ * ---------------------------
+ * Fill the halo around a body with the cells its edge cells see as
+ * 	neighbors, done once per generation so the kernels never test for
+ * 	the edges. The halo cells left and right of each row are filled
+ * 	first, then the halo rows are copied whole from the opposite edge,
+ * 	which also fills the corners. Dead edges leave the halo cleared.
+ *
+ * body: the body whose halo is filled.
+ */
+void body_fill_halo(body_t *body)
+{
+	size_t y, rows = body->rows, halo = body->halo;
+	size_t block = halo * body->stride * sizeof(*body->cells);
+	int topology = cell_meta.topology;
+
+	/* The cross-surface flips the rows across the left and right edges */
+	for (y=0; y < rows; y++)
+		row_fill_halo(body, BODY_ROW(body, y), BODY_ROW(body, topology == TOPOLOGY_CROSS ? rows - 1 - y : y));
+
+	switch (topology) {
+		case TOPOLOGY_DEAD:
+			memset(BODY_ROW(body, -(ptrdiff_t)halo) - 1, 0, block);
+			memset(BODY_ROW(body, rows) - 1, 0, block);
+			break;
+		case TOPOLOGY_TORUS:
+			memcpy(BODY_ROW(body, -(ptrdiff_t)halo) - 1, BODY_ROW(body, rows - halo) - 1, block);
+			memcpy(BODY_ROW(body, rows) - 1, BODY_ROW(body, 0) - 1, block);
+			break;
+		case TOPOLOGY_KLEIN:
+		case TOPOLOGY_CROSS:
+			for (y=1; y <= halo; y++) {
+				row_reverse(body, BODY_ROW(body, -(ptrdiff_t)y), BODY_ROW(body, rows - y));
+				row_reverse(body, BODY_ROW(body, rows + y - 1), BODY_ROW(body, y - 1));
+			}
+			break;
+	}
+}
+
+/*
+ * Function:	topology_find
+ * --------------------------
+ * Look up a topology by name.
+ *
+ * name: the name of the topology.
+ *
+ * returns: the topology, -1 if it is unknown.
+ */
+int topology_find(const char *name)
+{
+	int i;
+
+	for (i=0; topology_names[i]; i++)
+		if (!strcmp(name, topology_names[i]))
+			return i;
+
+	return -1;
+}
+
+/*
+ * Function:	topology_print_choices
+ * -----------------------------------
+ * Print the available topologies.
+ */
+void topology_print_choices(void)
+{
+	int i;
+
+	fprintf(stderr, "Available Topologies:\n");
+	for (i=0; topology_names[i]; i++)
+		fprintf(stderr, "\t%s\n", topology_names[i]);
+}
+
+/*
+ * Function:	topology_get
+ * -------------------------
+ * Get a cell of the body by mapping its coordinates through the topology,
+ * 	one cell at a time without the halo. Rows past the top or bottom edge
+ * 	are mapped first, then columns past the left or right edge, the same
+ * 	order body_fill_halo fills the corners in.
+ *
+ * body: the body holding the cell.
+ * x: the column of the cell, at most one body width outside the body.
+ * y: the row of the cell, at most one body height outside the body.
+ *
+ * returns: 1 if the cell is alive, 0 otherwise.
+ */
+int topology_get(const body_t *body, ptrdiff_t x, ptrdiff_t y)
+{
+	ptrdiff_t rows = body->rows, cols = body->cols;
+	int topology = cell_meta.topology;
+
+	if (y < 0 || y >= rows) {
+		if (topology == TOPOLOGY_DEAD)
+			return 0;
+		y = (y + rows) % rows;
+		if (topology == TOPOLOGY_KLEIN || topology == TOPOLOGY_CROSS)
+			x = cols - 1 - x;
+	}
+
+	if (x < 0 || x >= cols) {
+		if (topology == TOPOLOGY_DEAD)
+			return 0;
+		x = (x + cols) % cols;
+		if (topology == TOPOLOGY_CROSS)
+			y = rows - 1 - y;
+	}
+
+	return BODY_GET(body, x, y);
 }
 
 /*
@@ -152,23 +377,20 @@ void draw_generation(SDL_Renderer *renderer, body_t *body)
  * Default mode of cell generation, randomly assigns cells as alive in the center
  * 	1/4th of the body using a probability of being alive.
  *
- * body: pointer to the body that will store the updated cells.
- * pop: pointer to the population count used for tracking the body's progress.
+ * state: the engine's state that will store the cells.
  *
- * returns: pointer to body with its initial conditions set.
+ * returns: the engine's state with its initial conditions set.
  */
-static body_t *random_mode(body_t *body, int *pop)
+static void *random_mode(void *state)
 {
 	size_t x, y;
 
-	for (x=(size_t)(body->cols * 0.25); x < (size_t)(body->cols * 0.75); x++) {
-		for (y=(size_t)(body->rows * 0.25); y < (size_t)(body->rows * 0.75); y++) {
-			body->cells[x * body->cols + y]->alive = ((rand() % 100 + 1) <= cell_meta.alive_prob);
-			*pop += body->cells[x * body->cols + y]->alive;
-		}
-	}
+	for (y=(size_t)(cell_meta.rows * 0.25); y < (size_t)(cell_meta.rows * 0.75); y++)
+		for (x=(size_t)(cell_meta.cols * 0.25); x < (size_t)(cell_meta.cols * 0.75); x++)
+			if ((rand() % 100 + 1) <= cell_meta.alive_prob)
+				engine->set(state, x, y);
 
-	return body;
+	return state;
 }
 
 /*
@@ -176,12 +398,11 @@ static body_t *random_mode(body_t *body, int *pop)
  * ------------------------
  * A mode of cell generation, given a pattern selected by the user, generate the cells.
  *
- * body: pointer to the body that will store the updated cells.
- * pop: pointer to the population count used for tracking the body's progress.
+ * state: the engine's state that will store the cells.
  *
- * returns: pointer to body with its initial conditions set.
+ * returns: the engine's state with its initial conditions set.
  */
-static body_t *pattern_mode(body_t *body, int *pop)
+static void *pattern_mode(void *state)
 {
 	FILE *pattern_fd;
 	size_t len, x, y;
@@ -200,151 +421,668 @@ static body_t *pattern_mode(body_t *body, int *pop)
 	getline(&point, &len, pattern_fd); /* Skip header */
 	while (getline(&point, &len, pattern_fd) != -1) {
 		point[strlen(point) - 1] = '\0';
-		x = (size_t)atoi(strtok(point, ",")) + (body->cols * 0.5);
-		y = (size_t)atoi(strtok(NULL, ",")) + (body->rows * 0.5);
-		body->cells[x * body->cols + y]->alive = 1;
-		*pop += 1;
+		x = (size_t)atoi(strtok(point, ",")) + (cell_meta.cols * 0.5);
+		y = (size_t)atoi(strtok(NULL, ",")) + (cell_meta.rows * 0.5);
+		engine->set(state, x, y);
 	}
 
 	fclose(pattern_fd);
 	free(point);
 
-	return body;
+	return state;
 }
 
 /*
- * Function:	drawing_mode
- * ------------------------
- * A mode of cell generation, user selects the cells to be alive and then starts simulation.
+ * Function:	initial_generation
+ * -------------------------------
+ * The api for the selected mode to populate the initial generation. The
+ * 	cells are set straight in the engine, no body is needed. Drawing
+ * 	mode needs the window, see drawing_mode.
  *
- * renderer: SDL_Renderer used for rendering the window.
- * body: pointer to the body that will store the updated cells.
+ * state: the engine's state that will store the cells.
  * pop: pointer to the population count used for tracking the body's progress.
  *
- * returns: pointer to body with its initial conditions set.
- */
-static body_t *drawing_mode(SDL_Renderer *renderer, body_t *body, int *pop)
-{
-	int capturing_input, x, y, i;
-	SDL_Event event;
-	SDL_Color color = {0, 0, 0}; /* black */
-	char text[] = "DRAWING MODE";
-	int temp = cell_meta.grid_on;
-
-	cell_meta.grid_on = 1;
-
-	SDL_RenderClear(renderer);
-	draw_generation(renderer, body);
-	display_body_statistics(renderer, 0, *pop);
-	display_text(renderer, text, color, 24, 25, 100, 0, 0);
-	SDL_RenderPresent(renderer);
-
-	capturing_input = 1;
-	while(capturing_input) {
-		/* Poll for events */
-		while (SDL_PollEvent(&event))
-			switch (event.type) {
-				case SDL_QUIT:
-					return NULL;
-				case SDL_KEYDOWN:
-					switch (event.key.keysym.sym) {
-						case SDLK_SPACE:
-							capturing_input = 0;
-							break;
-						case SDLK_q:
-							return NULL;
-					}
-					break;
-				case SDL_MOUSEBUTTONDOWN:
-					if (event.button.button == SDL_BUTTON_LEFT) {
-						SDL_GetMouseState(&x, &y);
-						x /= cell_meta.width;
-						y /= cell_meta.height;
-						i = x * body->cols + y;
-
-						body->cells[i]->alive = !body->cells[i]->alive;
-						*pop += 2 * body->cells[i]->alive - 1;
-
-						SDL_RenderClear(renderer);
-						draw_generation(renderer, body);
-						display_body_statistics(renderer, 0, *pop);
-						display_text(renderer, text, color, 24, 25, 100, 0, 0);
-						SDL_RenderPresent(renderer);
-					}
-					break;
-			}
+ * returns: the engine's state with its initial conditions set.
+ */
+void *inital_generation(void *state, uint64_t *pop)
+{
+	void *seeded = NULL;
+
+	switch (mode) {
+		case 'r': seeded = random_mode(state); break;
+		case 'p': seeded = pattern_mode(state); break;
 	}
 
-	cell_meta.grid_on = temp;
-	return body;
+	*pop = engine->population(state);
+	return seeded;
 }
 
 /*
- * Function:	initial_generation
- * -------------------------------
- * The api for the selected mode to populate the initial body.
+ * Function:	cache_size
+ * -----------------------
+ * Get the size of a cache of the cpu.
  *
- * renderer: SDL_Renderer used for rendering the window when drawing mode is selected.
- * body: pointer to the body that will store the updated cells.
- * pop: pointer to the population count used for tracking the body's progress.
+ * name: the sysconf name of the cache size.
+ * fallback: the size used when the system does not report it.
  *
- * returns: pointer to body with its initial conditions set.
+ * returns: the size of the cache in bytes.
  */
-body_t *inital_generation(SDL_Renderer *renderer, body_t *body, int *pop)
+static long cache_size(int name, long fallback)
 {
-	*pop = 0;
+	long size = sysconf(name);
 
-	switch (mode) {
-		case 'r': return random_mode(body, pop);
-		case 'p': return pattern_mode(body, pop);
-		case 'd': return drawing_mode(renderer, body, pop);
+	return size > 0 ? size : fallback;
+}
+
+/*
+ * Function:	tile_tune
+ * ----------------------
+ * Size the tiles left at 0 to the caches. A tile row is as wide as the
+ * 	rows a kernel reads at once, the 2 * radius + 2 rows of the ltl
+ * 	column sums in the old and new bodies and their planes, allow in
+ * 	half of L1. A tile is as tall as the tile and its halo rows allow in
+ * 	half of L2, taller tiles also spread the start of the ltl column sums
+ * 	over more rows. Both are capped by TILE_*_TUNED_MAX.
+ */
+void tile_tune(void)
+{
+	long l1 = cache_size(_SC_LEVEL1_DCACHE_SIZE, TILE_L1_DEFAULT);
+	long l2 = cache_size(_SC_LEVEL2_CACHE_SIZE, TILE_L2_DEFAULT);
+	size_t copies = 2 * (rule_planes(&rule) + 1); /* the old and new bodies with their planes */
+	size_t row_size, rows;
+
+	if (!tile_meta.words) {
+		row_size = (2 * rule.radius + 2) * copies * sizeof(uint64_t);
+		tile_meta.words = l1 / 2 / row_size > 2 ? l1 / 2 / row_size - 2 : 1;
+		if (tile_meta.words > TILE_WORDS_TUNED_MAX)
+			tile_meta.words = TILE_WORDS_TUNED_MAX;
+	}
+
+	if (!tile_meta.rows) {
+		row_size = (tile_meta.words + 2) * copies * sizeof(uint64_t);
+		rows = l2 / 2 / row_size;
+		rows = rows > 2 * rule.radius ? rows - 2 * rule.radius : 0;
+		if (rows > TILE_ROWS_TUNED_MAX)
+			rows = TILE_ROWS_TUNED_MAX;
+		tile_meta.rows = rows > 1 ? rows : 1;
+	}
+}
+
+/*
+ * Function:	tile_span
+ * ----------------------
+ * Get the rows and words covered by a tile.
+ *
+ * body: the body the tile belongs to.
+ * tile_row: the row of the tile.
+ * tile_col: the column of the tile.
+ * span: pointer to the span being filled in.
+ */
+static void tile_span(const body_t *body, size_t tile_row, size_t tile_col, span_t *span)
+{
+	span->row_start = tile_row * body->tile_height;
+	span->row_end = span->row_start + body->tile_height < body->rows ? span->row_start + body->tile_height : body->rows;
+	span->word_start = tile_col * body->tile_words;
+	span->word_end = span->word_start + body->tile_words < body->words ? span->word_start + body->tile_words : body->words;
+}
+
+/*
+ * Function:	tile_near_edges
+ * ----------------------------
+ * Find the edges of the body a tile is within the rule's radius of, the
+ * 	cells its wrapped halo reaches across.
+ *
+ * body: the body the tile belongs to.
+ * tile_row: the row of the tile.
+ * tile_col: the column of the tile.
+ *
+ * returns: the EDGE_* flags of the edges the tile is near.
+ */
+static unsigned tile_near_edges(const body_t *body, size_t tile_row, size_t tile_col)
+{
+	span_t span;
+	unsigned edges = 0;
+
+	tile_span(body, tile_row, tile_col, &span);
+	if (span.row_start < body->halo)
+		edges |= EDGE_TOP;
+	if (span.row_end + body->halo > body->rows)
+		edges |= EDGE_BOTTOM;
+	if (span.word_start * BODY_WORD_BITS < body->halo)
+		edges |= EDGE_LEFT;
+	if ((span.word_end == body->words ? body->cols : span.word_end * BODY_WORD_BITS) + body->halo > body->cols)
+		edges |= EDGE_RIGHT;
+
+	return edges;
+}
+
+/*
+ * Function:	tile_edges
+ * -----------------------
+ * Find the edges of the body that have a changed tile near them. Through
+ * 	the halo a wrapped edge is a neighbor of the opposite edge, found once
+ * 	per generation so the tiles do not map their neighbors one by one.
+ *
+ * body: the body holding the last generation.
+ *
+ * returns: the EDGE_* flags of the edges near a changed tile.
+ */
+static unsigned tile_edges(const body_t *body)
+{
+	size_t r, c;
+	unsigned edges = 0;
+
+	for (r=0; r < body->tile_rows; r++)
+		for (c=0; c < body->tile_cols; c++)
+			if (body->tiles[r * body->tile_cols + c].changed)
+				edges |= tile_near_edges(body, r, c);
+
+	return edges;
+}
+
+/*
+ * Function:	tile_active
+ * ------------------------
+ * Check if a tile has to be recomputed, which is when it or one of its
+ * 	eight neighbors changed in the last generation. A tile that is not
+ * 	active is the same in the next generation. A tile near a wrapped edge
+ * 	is also active when a tile near the opposite edge changed. Tiles are
+ * 	at least as large as the rule's radius, so no other tile is reached.
+ *
+ * body: the body holding the last generation.
+ * tile_row: the row of the tile.
+ * tile_col: the column of the tile.
+ * edges: the changed edges seen through the halo, see tile_edges.
+ *
+ * returns: 1 if the tile must be recomputed, 0 otherwise.
+ */
+static int tile_active(const body_t *body, size_t tile_row, size_t tile_col, unsigned edges)
+{
+	size_t r, c;
+	size_t r_start = tile_row > 0 ? tile_row - 1 : 0;
+	size_t r_end = tile_row + 1 < body->tile_rows ? tile_row + 1 : tile_row;
+	size_t c_start = tile_col > 0 ? tile_col - 1 : 0;
+	size_t c_end = tile_col + 1 < body->tile_cols ? tile_col + 1 : tile_col;
+	unsigned near;
+
+	for (r=r_start; r <= r_end; r++)
+		for (c=c_start; c <= c_end; c++)
+			if (body->tiles[r * body->tile_cols + c].changed)
+				return 1;
+
+	if (!edges)
+		return 0;
+
+	near = tile_near_edges(body, tile_row, tile_col);
+	if (((near & EDGE_TOP) && (edges & EDGE_BOTTOM)) ||
+	    ((near & EDGE_BOTTOM) && (edges & EDGE_TOP)) ||
+	    ((near & EDGE_LEFT) && (edges & EDGE_RIGHT)) ||
+	    ((near & EDGE_RIGHT) && (edges & EDGE_LEFT)))
+		return 1;
+
+	return 0;
+}
+
+/*
+ * Function:	tile_compute
+ * -------------------------
+ * Compute one tile of the next generation with the selected kernel.
+ *
+ * body_new: pointer to the body that will store the updated cells.
+ * body_old: pointer to the body that stores the previous generation of cells.
+ * tile_row: the row of the tile.
+ * tile_col: the column of the tile.
+ *
+ * returns: the population of the tile.
+ */
+static uint64_t tile_compute(body_t *body_new, const body_t *body_old, size_t tile_row, size_t tile_col)
+{
+	size_t t = tile_row * body_old->tile_cols + tile_col;
+	span_t span;
+	int changed;
+
+	tile_span(body_old, tile_row, tile_col, &span);
+	body_new->tiles[t].pop = kernel->compute(body_new, body_old, &span, &changed);
+	body_new->tiles[t].changed = changed;
+
+	return body_new->tiles[t].pop;
+}
+
+/*
+ * Function:	tile_sleep
+ * -----------------------
+ * Carry a tile that is not active over to the next generation. It keeps
+ * 	its population and, when the new body does not already hold its
+ * 	cells from two generations ago, has its cells copied.
+ *
+ * body_new: pointer to the body that will store the updated cells.
+ * body_old: pointer to the body that stores the previous generation of cells.
+ * tile_row: the row of the tile.
+ * tile_col: the column of the tile.
+ * copy: 1 if the cells are copied, 0 if the new body holds them.
+ *
+ * returns: the population of the tile.
+ */
+static uint64_t tile_sleep(body_t *body_new, const body_t *body_old, size_t tile_row, size_t tile_col, int copy)
+{
+	size_t t = tile_row * body_old->tile_cols + tile_col;
+	size_t y, p;
+	span_t span;
+
+	tile_span(body_old, tile_row, tile_col, &span);
+	for (y=span.row_start; copy && y < span.row_end; y++)
+		for (p=0; p <= body_old->planes; p++)
+			memcpy(BODY_ROW(body_new, y) + span.word_start + p * body_new->plane_size,
+					BODY_ROW(body_old, y) + span.word_start + p * body_old->plane_size,
+					(span.word_end - span.word_start) * sizeof(uint64_t));
+	body_new->tiles[t].pop = body_old->tiles[t].pop;
+	body_new->tiles[t].changed = 0;
+
+	return body_new->tiles[t].pop;
+}
+
+/*
+ * Function:	compute_tile
+ * -------------------------
+ * Compute one tile of the next generation if it is active, see tile_sleep
+ * 	for the tiles that are not.
+ *
+ * body_new: pointer to the body that will store the updated cells.
+ * body_old: pointer to the body that stores the previous generation of cells.
+ * tile_row: the row of the tile.
+ * tile_col: the column of the tile.
+ * edges: the changed edges seen through the halo, see tile_edges.
+ * copy: 1 if a sleeping tile is copied, 0 if the new body holds it.
+ *
+ * returns: the population of the tile.
+ */
+static uint64_t compute_tile(body_t *body_new, const body_t *body_old, size_t tile_row, size_t tile_col,
+		unsigned edges, int copy)
+{
+	if (tile_active(body_old, tile_row, tile_col, edges))
+		return tile_compute(body_new, body_old, tile_row, tile_col);
+
+	return tile_sleep(body_new, body_old, tile_row, tile_col, copy);
+}
+
+/* Tile queue of each thread, see compute_steal */
+static struct tile_queue tile_queues[POOL_MAX_THREADS];
+
+/*
+ * Function:	tile_queue_pop
+ * ---------------------------
+ * Take the last slot of a thread's own queue.
+ *
+ * queue: the queue of the calling thread.
+ * slot: receives the slot of body->queue taken.
+ *
+ * returns: 1 if a slot was taken, 0 if the queue is empty.
+ */
+static int tile_queue_pop(struct tile_queue *queue, uint32_t *slot)
+{
+	uint64_t range = __atomic_load_n(&queue->range, __ATOMIC_ACQUIRE);
+
+	do {
+		if (range >> 32 == (uint32_t)range)
+			return 0;
+	} while (!__atomic_compare_exchange_n(&queue->range, &range, range - 1, 0,
+			__ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+	*slot = (uint32_t)range - 1;
+	return 1;
+}
+
+/*
+ * Function:	tile_queue_steal
+ * -----------------------------
+ * Move the first half of another thread's queue, rounded up, to the empty
+ * 	queue of the calling thread. The slots keep their place in body->queue,
+ * 	the queues only hold a range of them, so the move is a single swap.
+ *
+ * victim: the queue stolen from.
+ * thief: the empty queue of the calling thread.
+ *
+ * returns: 1 if slots were stolen, 0 if the victim is empty.
+ */
+static int tile_queue_steal(struct tile_queue *victim, struct tile_queue *thief)
+{
+	uint64_t range = __atomic_load_n(&victim->range, __ATOMIC_ACQUIRE);
+	uint64_t first, end, half;
+
+	do {
+		first = range >> 32;
+		end = (uint32_t)range;
+		if (first == end)
+			return 0;
+		half = (end - first + 1) / 2;
+	} while (!__atomic_compare_exchange_n(&victim->range, &range, (first + half) << 32 | end, 0,
+			__ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+	__atomic_store_n(&thief->range, first << 32 | (first + half), __ATOMIC_RELEASE);
+	return 1;
+}
+
+/*
+ * Function:	compute_steal
+ * --------------------------
+ * Pool job computing the next generation with work stealing. Each thread
+ * 	carries over the sleeping tiles of its band of tile rows and queues
+ * 	the active ones, then computes its queue and steals from the others
+ * 	when it runs out, so the threads stay busy when the activity sits in
+ * 	a few bands. Sleeping tiles are not touched, the new body already
+ * 	holds their cells from two generations ago, which are the same.
+ *
+ * arg: the generation_job holding the new and old bodies.
+ * id: the index of the calling thread.
+ * threads: the number of threads splitting the body.
+ *
+ * returns: the population of the tiles the thread carried over or computed.
+ */
+static uint64_t compute_steal(void *arg, size_t id, size_t threads)
+{
+	struct generation_job *job = arg;
+	const body_t *body_old = job->body_old;
+	body_t *body_new = job->body_new;
+	size_t tile_row, tile_col, i;
+	size_t first = body_old->tile_rows * id / threads * body_old->tile_cols;
+	size_t end = first;
+	uint32_t slot, t;
+	uint64_t pop = 0;
+
+	for (tile_row=body_old->tile_rows * id / threads; tile_row < body_old->tile_rows * (id + 1) / threads; tile_row++)
+		for (tile_col=0; tile_col < body_old->tile_cols; tile_col++)
+			if (tile_active(body_old, tile_row, tile_col, job->edges))
+				body_new->queue[end++] = tile_row * body_old->tile_cols + tile_col;
+			else
+				pop += tile_sleep(body_new, body_old, tile_row, tile_col, 0);
+
+	__atomic_store_n(&tile_queues[id].range, (uint64_t)first << 32 | end, __ATOMIC_RELEASE);
+	__atomic_add_fetch(&job->ready, 1, __ATOMIC_ACQ_REL);
+	/* The queues of the threads that are not ready are still empty */
+	while (__atomic_load_n(&job->ready, __ATOMIC_ACQUIRE) < threads)
+		sched_yield();
+
+	for (;;) {
+		while (tile_queue_pop(&tile_queues[id], &slot)) {
+			t = body_new->queue[slot];
+			pop += tile_compute(body_new, body_old, t / body_old->tile_cols, t % body_old->tile_cols);
+		}
+
+		for (i=1; i < threads; i++)
+			if (tile_queue_steal(&tile_queues[(id + i) % threads], &tile_queues[id]))
+				break;
+		if (i == threads)
+			break;
 	}
 
-	return NULL;
+	return pop;
 }
 
 /*
  * Function:	compute_generation
  * -------------------------------
  * Computes the next generation given the previous generation and the rules
- * 	defining the game of life.
+ * 	defining the game of life, using the selected kernel. The active tiles
+ * 	are shared across the thread pool, see compute_steal.
  *
  * body_new: pointer to the body that will store the updated cells.
  * body_old: pointer to the body that stores the previous generation of cells.
  * pop: pointer to the population count used for tracking the body's progress.
  */
-void compute_generation(body_t *body_new, body_t *body_old, int *pop)
+void compute_generation(body_t *body_new, body_t *body_old, uint64_t *pop)
 {
-	int neighbors, x, y, a, b, i;
-	*pop = 0;
+	struct generation_job job = { body_new, body_old, 0, 0 };
 
-	for (x=0; x < body_old->cols; x++) {
-		for (y=0; y < body_old->rows; y++) {
-			i = x * body_old->cols + y;
-			neighbors = body_old->cells[i]->alive ? -1 : 0;
+	body_fill_halo(body_old);
+	if (cell_meta.topology != TOPOLOGY_DEAD)
+		job.edges = tile_edges(body_old);
+	*pop = pool_run(pool, compute_steal, &job);
+}
 
-			for (a=-1; a < 2; a++) {
-				for (b=-1; b < 2; b++) {
-					if (!(x + a < 0 || x + a > body_old->cols - 1 ||
-					    y + b < 0 || y + b > body_old->rows - 1))
-						neighbors += body_old->cells[(x + a) * body_old->cols + (y + b)]->alive;
-				}
-			}
+/*
+ * Function:	compute_wave
+ * -------------------------
+ * Pool job computing one generation of a wavefront, thread id computes
+ * 	bodies[id + 1] from bodies[id] one tile row at a time. A tile row is
+ * 	started once the thread before has finished the tile row below it,
+ * 	so every thread follows the one before a tile row behind. Sleeping
+ * 	tiles are copied, the bodies do not hold two generations ago.
+ *
+ * arg: the wavefront_job holding the bodies and the progress of the threads.
+ * id: the index of the calling thread.
+ * threads: the number of threads in the pool, the generations of the wavefront.
+ *
+ * returns: the population of the last generation, 0 for the other threads.
+ */
+static uint64_t compute_wave(void *arg, size_t id, size_t threads)
+{
+	struct wavefront_job *job = arg;
+	const body_t *body_old = job->bodies[id];
+	body_t *body_new = job->bodies[id + 1];
+	size_t tile_row, tile_col, needed;
+	uint64_t pop = 0;
 
-			if (body_old->cells[i]->alive && ((neighbors < 2) || (neighbors > 3)))
-				body_new->cells[i]->alive = 0;
-			else if (!body_old->cells[i]->alive && (neighbors == 3))
-				body_new->cells[i]->alive = 1;
+	for (tile_row=0; tile_row < body_old->tile_rows; tile_row++) {
+		/* The tile row below holds the halo and the changed flags read */
+		needed = tile_row + 2 < body_old->tile_rows ? tile_row + 2 : body_old->tile_rows;
+		while (id > 0 && __atomic_load_n(&job->progress[id - 1].tile_rows, __ATOMIC_ACQUIRE) < needed)
+			sched_yield();
+
+		for (tile_col=0; tile_col < body_old->tile_cols; tile_col++)
+			pop += compute_tile(body_new, body_old, tile_row, tile_col, 0, 1);
+
+		__atomic_store_n(&job->progress[id].tile_rows, tile_row + 1, __ATOMIC_RELEASE);
+	}
+
+	return id + 1 == threads ? pop : 0;
+}
+
+/*
+ * Function:	compute_wavefront
+ * ------------------------------
+ * Computes as many generations as there are threads in one run of the
+ * 	pool, thread i computing the generation after thread i - 1 a tile
+ * 	row behind it, see compute_wave. The threads only meet once for all
+ * 	the generations instead of once per generation. Wrapped edges need
+ * 	the last rows of a generation before its first, only dead edges are
+ * 	pipelined.
+ *
+ * bodies: bodies[0] holds the cells, bodies[t] receives the last generation,
+ * 	t the threads of the pool, and the bodies between the ones before it.
+ * pop: pointer to the population count used for tracking the body's progress.
+ */
+void compute_wavefront(body_t **bodies, uint64_t *pop)
+{
+	struct wave_progress progress[POOL_MAX_THREADS] = { 0 };
+	struct wavefront_job job = { bodies, progress };
+
+	body_fill_halo(bodies[0]);
+	*pop = pool_run(pool, compute_wave, &job);
+}
+
+/* Scratch bodies of each thread, see compute_pass */
+static body_t *pass_scratch[POOL_MAX_THREADS][2];
+
+/*
+ * Function:	pass_load
+ * ----------------------
+ * Copy rows of a body and their decay planes into a scratch body. Rows
+ * 	past the top and bottom are the rows the wrapped edges glue there,
+ * 	flipped end to end each time a Klein bottle's edge is crossed.
+ *
+ * scratch: the scratch body, its row 0 receiving row first.
+ * body: the body the rows are copied from.
+ * first: the row of the body copied to row 0 of scratch, may be negative.
+ * rows: the number of rows copied.
+ */
+static void pass_load(body_t *scratch, const body_t *body, ptrdiff_t first, size_t rows)
+{
+	size_t i, p;
+	ptrdiff_t y;
+	int flip;
+
+	for (i=0; i < rows; i++) {
+		y = first + (ptrdiff_t)i;
+		flip = 0;
+		for (; y < 0; y += body->rows)
+			flip ^= cell_meta.topology == TOPOLOGY_KLEIN;
+		for (; y >= (ptrdiff_t)body->rows; y -= body->rows)
+			flip ^= cell_meta.topology == TOPOLOGY_KLEIN;
+
+		for (p=0; p <= body->planes; p++) {
+			/* Plane 0 is the alive cells, the decay planes follow */
+			uint64_t *dst = BODY_ROW(scratch, i) + p * scratch->plane_size;
+			const uint64_t *src = BODY_ROW(body, y) + p * body->plane_size;
+
+			if (flip)
+				row_reverse(body, dst, src);
 			else
-				body_new->cells[i]->alive = body_old->cells[i]->alive;
+				memcpy(dst - 1, src - 1, body->stride * sizeof(*dst));
+		}
+	}
+}
+
+/*
+ * Function:	compute_pass
+ * -------------------------
+ * Pool job advancing one thread's bands of tile rows several generations.
+ * 	Each band is copied to a scratch body with the rows the generations
+ * 	reach, rule.radius rows per generation on either side, and stepped
+ * 	there, every generation computing rule.radius fewer rows on either
+ * 	side. A dead edge is exact and its side does not shrink. The band is
+ * 	then copied back, so the body is read and written once per pass.
+ *
+ * arg: the pass_job holding the new and old bodies.
+ * id: the index of the calling thread.
+ * threads: the number of threads splitting the body.
+ *
+ * returns: the population of the bands.
+ */
+static uint64_t compute_pass(void *arg, size_t id, size_t threads)
+{
+	struct pass_job *job = arg;
+	const body_t *body_old = job->body_old;
+	body_t *body_new = job->body_new;
+	body_t **scratch = pass_scratch[id], *temp;
+	size_t reach = job->generations * body_old->halo;
+	size_t bands = (body_old->rows + job->band - 1) / job->band;
+	size_t band, start, end, top, bottom, rows, g, y, p, r, c, t;
+	int dead = cell_meta.topology == TOPOLOGY_DEAD, changed;
+	span_t span, tile;
+	uint64_t pop = 0;
+
+	for (band=bands * id / threads; band < bands * (id + 1) / threads; band++) {
+		start = band * job->band;
+		end = start + job->band < body_old->rows ? start + job->band : body_old->rows;
+		top = dead && start < reach ? start : reach; /* rows above the band */
+		bottom = dead && body_old->rows - end < reach ? body_old->rows - end : reach;
+		rows = top + end - start + bottom;
+
+		for (r=0; r < 2; r++) {
+			if (!scratch[r] || scratch[r]->stride != body_old->stride ||
+			    scratch[r]->plane_size < (rows + 2 * body_old->halo) * body_old->stride) {
+				if (scratch[r])
+					body_destory(scratch[r]);
+				scratch[r] = body_init(job->band + 2 * reach, body_old->cols);
+			}
+			scratch[r]->rows = rows;
+			/* Dead rows below an exact bottom edge */
+			for (p=0; p <= body_old->planes; p++)
+				memset(BODY_ROW(scratch[r], rows) - 1 + p * scratch[r]->plane_size, 0,
+						body_old->halo * body_old->stride * sizeof(uint64_t));
+		}
+		pass_load(scratch[0], body_old, (ptrdiff_t)start - (ptrdiff_t)top, rows);
+
+		for (g=1; g <= job->generations; g++) {
+			span.row_start = top == reach ? g * body_old->halo : 0;
+			span.row_end = bottom == reach ? rows - g * body_old->halo : rows;
+
+			/* The rows read this generation see across the left and right edges */
+			for (y=span.row_start >= body_old->halo ? span.row_start - body_old->halo : 0;
+			     y < rows && y < span.row_end + body_old->halo; y++)
+				row_fill_halo(scratch[0], BODY_ROW(scratch[0], y), BODY_ROW(scratch[0], y));
+
+			/* Tile wide strips keep the rows a kernel works on in L1 */
+			for (span.word_start=0; span.word_start < body_old->words; span.word_start += body_old->tile_words) {
+				span.word_end = span.word_start + body_old->tile_words < body_old->words ?
+					span.word_start + body_old->tile_words : body_old->words;
+				kernel->compute(scratch[1], scratch[0], &span, &changed);
+			}
+
+			temp = scratch[0];
+			scratch[0] = scratch[1];
+			scratch[1] = temp;
+		}
 
-			*pop += body_new->cells[i]->alive;
+		for (y=start; y < end; y++)
+			for (p=0; p <= body_old->planes; p++)
+				memcpy(BODY_ROW(body_new, y) + p * body_new->plane_size,
+						BODY_ROW(scratch[0], top + y - start) + p * scratch[0]->plane_size,
+						body_old->words * sizeof(uint64_t));
+
+		/* Every tile of the band is counted again and left changed */
+		for (r=start / body_new->tile_height; r < body_new->tile_rows && r * body_new->tile_height < end; r++) {
+			for (c=0; c < body_new->tile_cols; c++) {
+				t = r * body_new->tile_cols + c;
+				tile_span(body_new, r, c, &tile);
+				body_new->tiles[t].pop = 0;
+				for (y=tile.row_start; y < tile.row_end; y++)
+					for (p=tile.word_start; p < tile.word_end; p++)
+						body_new->tiles[t].pop += __builtin_popcountll(BODY_ROW(body_new, y)[p]);
+				body_new->tiles[t].changed = 1;
+				pop += body_new->tiles[t].pop;
+			}
 		}
 	}
 
+	return pop;
+}
+
+/*
+ * Function:	compute_generations
+ * --------------------------------
+ * Computes several generations in one pass over the body, see
+ * 	compute_pass. The bands are as many tile rows as fit in half of L2
+ * 	with the rows the generations reach. The generations computed twice
+ * 	near the bands' edges are traded for reading and writing the body
+ * 	once instead of once per generation. The left and right edges of
+ * 	the cross-surface flip the rows, it is not computed in bands.
+ *
+ * body_new: pointer to the body that will store the updated cells.
+ * body_old: pointer to the body that stores the previous generation of cells.
+ * generations: the number of generations to compute.
+ * pop: pointer to the population count used for tracking the body's progress.
+ */
+void compute_generations(body_t *body_new, body_t *body_old, size_t generations, uint64_t *pop)
+{
+	struct pass_job job = { body_new, body_old, generations, 0 };
+	size_t copies = 2 * (body_old->planes + 1);
+	size_t fit = cache_size(_SC_LEVEL2_CACHE_SIZE, TILE_L2_DEFAULT) / 2 / (body_old->stride * copies * sizeof(uint64_t));
+	size_t overlap = 2 * generations * body_old->halo;
+
+	job.band = fit > overlap + body_old->tile_height ? (fit - overlap) / body_old->tile_height * body_old->tile_height :
+		body_old->tile_height;
+	*pop = pool_run(pool, compute_pass, &job);
+}
+
+/*
+ * Function:	compute_generations_destroy
+ * ----------------------------------------
+ * Free the scratch bodies compute_pass allocated for each thread.
+ */
+void compute_generations_destroy(void)
+{
+	size_t i, r;
+
+	for (i=0; i < POOL_MAX_THREADS; i++)
+		for (r=0; r < 2; r++)
+			if (pass_scratch[i][r]) {
+				body_destory(pass_scratch[i][r]);
+				pass_scratch[i][r] = NULL;
+			}
 }
 
-void export_body(body_t *body, int generation, int population)
+void export_body(body_t *body, uint64_t generation)
 {
 	FILE *export_fd;
 	int x, y;
@@ -362,8 +1100,8 @@ void export_body(body_t *body, int generation, int population)
 	strcat(export_path, export_rel_path);
 
 	mkdir(export_path, 0755);
-	sprintf(export_file, "%s/mode%c-n%d-d%d-%d-%02d-%02d-%02d:%02d:%02d.csv",
-		export_path, mode, cell_meta.rows, cell_meta.height, tm.tm_year + 1900,
+	sprintf(export_file, "%s/mode%c-n%d-d%d-g%" PRIu64 "-%d-%02d-%02d-%02d:%02d:%02d.csv",
+		export_path, mode, cell_meta.rows, cell_meta.height, generation, tm.tm_year + 1900,
 		tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec);
 
 	export_fd = fopen(export_file, "w");
@@ -375,7 +1113,7 @@ void export_body(body_t *body, int generation, int population)
 	fprintf(export_fd, "x,y\n");
 	for (x=0; x < body->cols; x++) {
 		for (y=0; y < body->rows; y++) {
-			if (body->cells[x * body->cols + y]->alive)
+			if (BODY_GET(body, x, y))
 				fprintf(export_fd, "%d,%d\n", x, y);
 		}
 	}
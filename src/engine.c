@@ -0,0 +1,369 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cell.h"
+#include "engine.h"
+#include "pool.h"
+#include "utilities.h"
+#include "rule.h"
+#include "hashlife.h"
+#include "sparse.h"
+
+/*
+ * Function:	reference_init
+ * ---------------------------
+ * Initialize the tile engine, a pair of bodies the size of the window.
+ *
+ * rows: number of rows in the body.
+ * cols: number of cols in the body.
+ *
+ * returns: pointer to the newly allocated engine state.
+ */
+static void *reference_init(size_t rows, size_t cols)
+{
+	reference_t *ref_new = calloc(1, sizeof(*ref_new));
+	if (!ref_new) {
+		perror("reference_init: Failed to malloc ref_new");
+		exit(EXIT_FAILURE);
+	}
+
+	ref_new->body = body_init(rows, cols);
+	ref_new->body_old = body_init(rows, cols);
+	ref_new->pop = 0;
+
+	ref_new->changed = malloc(ref_new->body->tile_rows * ref_new->body->tile_cols);
+	if (!ref_new->changed) {
+		perror("reference_init: Failed to malloc ref_new->changed");
+		exit(EXIT_FAILURE);
+	}
+	memset(ref_new->changed, 1, ref_new->body->tile_rows * ref_new->body->tile_cols);
+
+	return ref_new;
+}
+
+/*
+ * Function:	reference_load
+ * ---------------------------
+ * Replace the cells of the tile engine with the cells of a body.
+ *
+ * state: the tile engine.
+ * body: the body holding the cells.
+ */
+static void reference_load(void *state, const body_t *body)
+{
+	reference_t *ref = state;
+
+	body_copy(ref->body, body);
+	ref->pop = body_population(ref->body);
+	memset(ref->changed, 1, ref->body->tile_rows * ref->body->tile_cols);
+}
+
+/*
+ * Function:	reference_set
+ * --------------------------
+ * Make a cell of the tile engine alive, waking up its tile.
+ *
+ * state: the tile engine.
+ * x: the column of the cell.
+ * y: the row of the cell.
+ */
+static void reference_set(void *state, size_t x, size_t y)
+{
+	reference_t *ref = state;
+	body_t *body = ref->body;
+
+	if (BODY_GET(body, x, y))
+		return;
+
+	BODY_SET(body, x, y);
+	body->tiles[y / body->tile_height * body->tile_cols + x / BODY_WORD_BITS / body->tile_words].changed = 1;
+	ref->changed[y / body->tile_height * body->tile_cols + x / BODY_WORD_BITS / body->tile_words] = 1;
+	ref->pop++;
+}
+
+/*
+ * Function:	reference_wavefront
+ * --------------------------------
+ * Advance the tile engine one generation per thread with a wavefront, see
+ * 	compute_wavefront. The generations pass through spare bodies, the
+ * 	last two end up in body and body_old like after single generations.
+ *
+ * ref: the tile engine.
+ */
+static void reference_wavefront(reference_t *ref)
+{
+	body_t *bodies[POOL_MAX_THREADS + 1];
+	size_t i, generations = pool->threads;
+
+	bodies[0] = ref->body;
+	for (i=1; i < generations; i++) {
+		if (!ref->spare[i - 1])
+			ref->spare[i - 1] = body_init(ref->body->rows, ref->body->cols);
+		bodies[i] = ref->spare[i - 1];
+	}
+	bodies[generations] = ref->body_old;
+
+	compute_wavefront(bodies, &ref->pop);
+	for (i=1; i <= generations; i++)
+		reference_changed(ref, bodies[i]);
+
+	ref->body = bodies[generations];
+	ref->body_old = bodies[generations - 1];
+	ref->spare[generations - 2] = bodies[0];
+}
+
+/*
+ * Function:	reference_changed
+ * ------------------------------
+ * Add the tiles that changed in a generation to the ones changed since
+ * 	the last read.
+ *
+ * ref: the tile engine.
+ * body: the body holding the generation.
+ */
+static void reference_changed(reference_t *ref, const body_t *body)
+{
+	size_t i;
+
+	for (i=0; i < body->tile_rows * body->tile_cols; i++)
+		ref->changed[i] |= body->tiles[i].changed;
+}
+
+/*
+ * Function:	reference_step
+ * ---------------------------
+ * Advance the tile engine. With a wavefront every thread computes its own
+ * 	generation, otherwise tile_meta.generations generations are computed
+ * 	per pass over the body while enough are left, then one at a time.
+ *
+ * state: the tile engine.
+ * generations: the number of generations.
+ */
+static void reference_step(void *state, uint64_t generations)
+{
+	reference_t *ref = state;
+	body_t *temp;
+	uint64_t pass = tile_meta.generations;
+
+	if (wavefront && pool->threads > 1 && cell_meta.topology == TOPOLOGY_DEAD) {
+		for (; generations >= pool->threads; generations -= pool->threads)
+			reference_wavefront(ref);
+		pass = 1;
+	}
+	if (cell_meta.topology == TOPOLOGY_CROSS) /* See compute_generations */
+		pass = 1;
+
+	while (generations) {
+		/* Ping-pong buffer */
+		temp = ref->body;
+		ref->body = ref->body_old;
+		ref->body_old = temp;
+
+		if (pass > 1 && generations >= pass) {
+			compute_generations(ref->body, ref->body_old, pass, &ref->pop);
+			generations -= pass;
+		} else {
+			compute_generation(ref->body, ref->body_old, &ref->pop);
+			generations--;
+		}
+		reference_changed(ref, ref->body);
+	}
+}
+
+/*
+ * Function:	reference_population
+ * ---------------------------------
+ * Get the population of the tile engine.
+ *
+ * state: the tile engine.
+ *
+ * returns: the number of alive cells.
+ */
+static uint64_t reference_population(void *state)
+{
+	return ((reference_t *)state)->pop;
+}
+
+/*
+ * Function:	reference_read
+ * ---------------------------
+ * Copy the cells of the tile engine into a body of the same size. Only
+ * 	the tiles that changed since the last read are marked changed, so
+ * 	the window only redraws those, see draw_generation.
+ *
+ * state: the tile engine.
+ * body: the body receiving the cells.
+ */
+static void reference_read(void *state, body_t *body)
+{
+	reference_t *ref = state;
+	size_t i;
+
+	body_copy(body, ref->body);
+	for (i=0; i < body->tile_rows * body->tile_cols; i++) {
+		body->tiles[i].changed = ref->changed[i];
+		ref->changed[i] = 0;
+	}
+}
+
+/*
+ * Function:	reference_destroy
+ * ------------------------------
+ * Destroy the tile engine.
+ *
+ * state: the tile engine.
+ */
+static void reference_destroy(void *state)
+{
+	reference_t *ref = state;
+	size_t i;
+
+	body_destory(ref->body);
+	body_destory(ref->body_old);
+	for (i=0; i < POOL_MAX_THREADS - 1; i++)
+		if (ref->spare[i])
+			body_destory(ref->spare[i]);
+	compute_generations_destroy();
+	free(ref->changed);
+	free(ref);
+}
+
+static void *hashlife_engine_init(size_t rows, size_t cols)
+{
+	(void)rows; /* unbounded, the body only sets the region read */
+	(void)cols;
+	return hashlife_init(hashlife_meta.cache_mb);
+}
+
+static void hashlife_engine_load(void *state, const body_t *body)
+{
+	hashlife_load(state, body);
+}
+
+static void hashlife_engine_set(void *state, size_t x, size_t y)
+{
+	hashlife_set(state, x, y);
+}
+
+/*
+ * Function:	hashlife_engine_step
+ * ---------------------------------
+ * Advance the HashLife universe by one power of two step for every bit
+ * 	set in the number of generations. The results of the nodes too
+ * 	small for the larger steps are shared by all of them.
+ *
+ * state: the HashLife universe.
+ * generations: the number of generations.
+ */
+static void hashlife_engine_step(void *state, uint64_t generations)
+{
+	unsigned step_log;
+
+	for (step_log=0; step_log <= HASHLIFE_STEP_LOG_MAX; step_log++)
+		if (generations & (uint64_t)1 << step_log)
+			hashlife_step(state, step_log);
+}
+
+static uint64_t hashlife_engine_population(void *state)
+{
+	return hashlife_population(state);
+}
+
+static void hashlife_engine_read(void *state, body_t *body)
+{
+	hashlife_read(state, body);
+}
+
+static void hashlife_engine_destroy(void *state)
+{
+	hashlife_destroy(state);
+}
+
+static void *sparse_engine_init(size_t rows, size_t cols)
+{
+	(void)rows; /* unbounded, the body only sets the region read */
+	(void)cols;
+	return sparse_init();
+}
+
+static void sparse_engine_load(void *state, const body_t *body)
+{
+	sparse_load(state, body);
+}
+
+static void sparse_engine_set(void *state, size_t x, size_t y)
+{
+	sparse_set(state, x, y);
+}
+
+static void sparse_engine_step(void *state, uint64_t generations)
+{
+	uint64_t i;
+
+	for (i=0; i < generations; i++)
+		sparse_step(state);
+}
+
+static uint64_t sparse_engine_population(void *state)
+{
+	return sparse_population(state);
+}
+
+static void sparse_engine_read(void *state, body_t *body)
+{
+	sparse_read(state, body);
+}
+
+static void sparse_engine_destroy(void *state)
+{
+	sparse_destroy(state);
+}
+
+static const engine_t engines[] = {
+	{ "reference", 0, STEP_LOG_MAX, RULE_FAMILY_CONWAY | RULE_FAMILY_TOTALISTIC | RULE_FAMILY_GENERATIONS |
+		RULE_FAMILY_LTL | RULE_FAMILY_ISOTROPIC,
+		reference_init, reference_load, reference_set, reference_step,
+		reference_population, reference_read, reference_destroy },
+	{ "hashlife", 1, HASHLIFE_STEP_LOG_MAX, RULE_FAMILY_CONWAY | RULE_FAMILY_TOTALISTIC,
+		hashlife_engine_init, hashlife_engine_load, hashlife_engine_set, hashlife_engine_step,
+		hashlife_engine_population, hashlife_engine_read, hashlife_engine_destroy },
+	{ "sparse", 1, STEP_LOG_MAX, RULE_FAMILY_CONWAY | RULE_FAMILY_TOTALISTIC,
+		sparse_engine_init, sparse_engine_load, sparse_engine_set, sparse_engine_step,
+		sparse_engine_population, sparse_engine_read, sparse_engine_destroy },
+	{ NULL }
+};
+
+/*
+ * Function:	engine_find
+ * ------------------------
+ * Look up an engine by name.
+ *
+ * name: the name of the engine.
+ *
+ * returns: pointer to the engine, NULL if it is unknown.
+ */
+const engine_t *engine_find(const char *name)
+{
+	const engine_t *e;
+
+	for (e=engines; e->name; e++)
+		if (!strcmp(name, e->name))
+			return e;
+
+	return NULL;
+}
+
+/*
+ * Function:	engine_print_choices
+ * ---------------------------------
+ * Print the available engines.
+ */
+void engine_print_choices(void)
+{
+	const engine_t *e;
+
+	fprintf(stderr, "Available Engines:\n");
+	for (e=engines; e->name; e++)
+		fprintf(stderr, "\t%s%s\n", e->name, e->unbounded ? " (unbounded universe)" : "");
+}
@@ -0,0 +1,582 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+
+#include "cell.h"
+#include "hashlife.h"
+#include "rule.h"
+
+#define NODE_HASH(nw, ne, sw, se) \
+	((((uintptr_t)(nw) * 0x9E3779B97F4A7C15ULL + (uintptr_t)(ne)) * 0x9E3779B97F4A7C15ULL + \
+	(uintptr_t)(sw)) * 0x9E3779B97F4A7C15ULL + (uintptr_t)(se))
+
+/*
+ * Function:	hashlife_init
+ * --------------------------
+ * Initialize an empty HashLife universe.
+ *
+ * cache_mb: the size of the node cache in megabytes. The cache is garbage
+ * 	collected between steps once it grows past this size, a soft limit
+ * 	a single step may go over.
+ *
+ * returns: pointer to the newly allocated universe.
+ */
+hashlife_t *hashlife_init(size_t cache_mb)
+{
+	hashlife_t *hl_new = calloc(1, sizeof(*hl_new));
+	if (!hl_new) {
+		perror("hashlife_init: Failed to malloc hl_new");
+		exit(EXIT_FAILURE);
+	}
+
+	hl_new->max_nodes = cache_mb * 1024 * 1024 / sizeof(hl_node_t);
+	for (hl_new->buckets = 1024; hl_new->buckets < hl_new->max_nodes; hl_new->buckets <<= 1);
+
+	hl_new->table = calloc(hl_new->buckets, sizeof(*hl_new->table));
+	if (!hl_new->table) {
+		perror("hashlife_init: Failed to malloc hl_new->table");
+		exit(EXIT_FAILURE);
+	}
+
+	hl_new->leaf[1].pop = 1;
+	hl_new->root = node_empty(hl_new, 3);
+
+	return hl_new;
+}
+
+/*
+ * Function:	hashlife_destroy
+ * -----------------------------
+ * Destroy a HashLife universe and all of its nodes.
+ *
+ * hl: pointer to the universe allocated in memory.
+ */
+void hashlife_destroy(hashlife_t *hl)
+{
+	size_t i;
+
+	for (i=0; i < hl->chunk_count; i++)
+		free(hl->chunks[i]);
+	free(hl->chunks);
+	free(hl->table);
+	free(hl);
+}
+
+/*
+ * Function:	node_alloc
+ * -----------------------
+ * Take a node from the free list, allocating a new chunk of nodes when
+ * 	the free list is empty.
+ *
+ * hl: the universe owning the node.
+ *
+ * returns: pointer to the uninitialized node.
+ */
+static hl_node_t *node_alloc(hashlife_t *hl)
+{
+	size_t i;
+	hl_node_t *chunk, *node;
+
+	if (!hl->free_list) {
+		chunk = malloc(HASHLIFE_CHUNK_NODES * sizeof(*chunk));
+		hl->chunks = realloc(hl->chunks, (hl->chunk_count + 1) * sizeof(*hl->chunks));
+		if (!chunk || !hl->chunks) {
+			perror("node_alloc: Failed to malloc chunk");
+			exit(EXIT_FAILURE);
+		}
+		hl->chunks[hl->chunk_count++] = chunk;
+
+		for (i=0; i < HASHLIFE_CHUNK_NODES; i++) {
+			chunk[i].next = hl->free_list;
+			hl->free_list = &chunk[i];
+		}
+	}
+
+	node = hl->free_list;
+	hl->free_list = node->next;
+	return node;
+}
+
+/*
+ * Function:	node_find
+ * ----------------------
+ * Get the canonical node with the given children, creating it if it is not
+ * 	in the hash table yet.
+ *
+ * hl: the universe owning the node.
+ * nw, ne, sw, se: the four quadrants of the node.
+ *
+ * returns: pointer to the canonical node.
+ */
+static hl_node_t *node_find(hashlife_t *hl, hl_node_t *nw, hl_node_t *ne, hl_node_t *sw, hl_node_t *se)
+{
+	size_t bucket = NODE_HASH(nw, ne, sw, se) & (hl->buckets - 1);
+	hl_node_t *node;
+
+	for (node=hl->table[bucket]; node; node = node->next)
+		if (node->nw == nw && node->ne == ne && node->sw == sw && node->se == se)
+			return node;
+
+	node = node_alloc(hl);
+	node->nw = nw;
+	node->ne = ne;
+	node->sw = sw;
+	node->se = se;
+	node->result = NULL;
+	node->result_log = 0;
+	node->pop = nw->pop + ne->pop + sw->pop + se->pop;
+	node->level = nw->level + 1;
+	node->mark = 0;
+
+	node->next = hl->table[bucket];
+	hl->table[bucket] = node;
+	hl->nodes++;
+
+	return node;
+}
+
+/*
+ * Function:	node_empty
+ * -----------------------
+ * Get the empty node of a level.
+ *
+ * hl: the universe owning the node.
+ * level: the level of the node.
+ *
+ * returns: pointer to the canonical empty node.
+ */
+static hl_node_t *node_empty(hashlife_t *hl, uint32_t level)
+{
+	hl_node_t *e;
+
+	if (!level)
+		return &hl->leaf[0];
+
+	if (!hl->empty[level]) {
+		e = node_empty(hl, level - 1);
+		hl->empty[level] = node_find(hl, e, e, e, e);
+	}
+
+	return hl->empty[level];
+}
+
+/*
+ * Function:	node_mark
+ * ----------------------
+ * Mark a node and everything below it as reachable.
+ *
+ * node: the node being marked.
+ */
+static void node_mark(hl_node_t *node)
+{
+	if (node->mark || !node->level)
+		return;
+
+	node->mark = 1;
+	node_mark(node->nw);
+	node_mark(node->ne);
+	node_mark(node->sw);
+	node_mark(node->se);
+}
+
+/*
+ * Function:	hashlife_gc
+ * ------------------------
+ * Free every node that is not reachable from the root or the empty nodes.
+ * 	Memoized results of the surviving nodes are kept only if they survive
+ * 	as well.
+ *
+ * hl: the universe being collected.
+ */
+static void hashlife_gc(hashlife_t *hl)
+{
+	size_t i;
+	hl_node_t **link, *node;
+
+	node_mark(hl->root);
+	for (i=1; i <= HASHLIFE_MAX_LEVEL; i++)
+		if (hl->empty[i])
+			node_mark(hl->empty[i]);
+
+	for (i=0; i < hl->buckets; i++)
+		for (node=hl->table[i]; node; node = node->next)
+			if (node->mark && node->result && !node->result->mark)
+				node->result = NULL;
+
+	for (i=0; i < hl->buckets; i++) {
+		link = &hl->table[i];
+		while ((node = *link)) {
+			if (node->mark) {
+				node->mark = 0;
+				link = &node->next;
+			} else {
+				*link = node->next;
+				node->next = hl->free_list;
+				hl->free_list = node;
+				hl->nodes--;
+			}
+		}
+	}
+}
+
+/*
+ * Function:	hashlife_result_log
+ * --------------------------------
+ * Get log2 of the generations a node's RESULT advances at the current step
+ * 	size. Nodes too small for the step advance as far as they can, so
+ * 	their results are the same for every larger step size and are kept
+ * 	when the step size changes.
+ *
+ * hl: the universe owning the node.
+ * node: a node of level 2 or more.
+ *
+ * returns: min(level - 2, step_log).
+ */
+static unsigned hashlife_result_log(hashlife_t *hl, hl_node_t *node)
+{
+	return node->level - 2 < hl->step_log ? node->level - 2 : hl->step_log;
+}
+
+/*
+ * Function:	hashlife_base
+ * --------------------------
+ * Compute the center 2x2 cells of a 4x4 node one generation ahead.
+ *
+ * hl: the universe owning the node.
+ * node: the level 2 node.
+ *
+ * returns: pointer to the level 1 result.
+ */
+static hl_node_t *hashlife_base(hashlife_t *hl, hl_node_t *node)
+{
+	hl_node_t *quad[4] = { node->nw, node->ne, node->sw, node->se };
+	hl_node_t *cells[4];
+	int x, y, a, b, i, neighbors, alive;
+	uint16_t bits = 0;
+
+	/* Gather the cells, bit y * 4 + x */
+	for (i=0; i < 4; i++) {
+		x = (i % 2) * 2;
+		y = (i / 2) * 2;
+		bits |= quad[i]->nw->pop << (y * 4 + x);
+		bits |= quad[i]->ne->pop << (y * 4 + x + 1);
+		bits |= quad[i]->sw->pop << ((y + 1) * 4 + x);
+		bits |= quad[i]->se->pop << ((y + 1) * 4 + x + 1);
+	}
+
+	for (i=0; i < 4; i++) {
+		x = 1 + i % 2;
+		y = 1 + i / 2;
+		alive = (bits >> (y * 4 + x)) & 1;
+		neighbors = -alive;
+		for (b=-1; b < 2; b++)
+			for (a=-1; a < 2; a++)
+				neighbors += (bits >> ((y + b) * 4 + x + a)) & 1;
+
+		cells[i] = &hl->leaf[RULE_NEXT(rule, alive, neighbors)];
+	}
+
+	return node_find(hl, cells[0], cells[1], cells[2], cells[3]);
+}
+
+/*
+ * Function:	hashlife_result
+ * ----------------------------
+ * The RESULT of a node, its center half advanced min(2^(level - 2),
+ * 	2^step_log) generations. Nine overlapping sub-nodes are advanced, or
+ * 	just centered when the step is smaller than the node allows, then
+ * 	regrouped into four nodes that are advanced to the final result.
+ * 	Results are memoized in the node with the step they advance, a
+ * 	result for another step size is recomputed.
+ *
+ * hl: the universe owning the node.
+ * node: a node of level 2 or more.
+ *
+ * returns: pointer to the node one level below holding the result.
+ */
+static hl_node_t *hashlife_result(hashlife_t *hl, hl_node_t *node)
+{
+	hl_node_t *n[9], *r[9];
+	unsigned result_log = hashlife_result_log(hl, node);
+	int i, fast;
+
+	if (node->result && node->result_log == result_log)
+		return node->result;
+
+	node->result_log = result_log;
+	if (node->level == 2) {
+		node->result = hashlife_base(hl, node);
+		return node->result;
+	}
+
+	n[0] = node->nw;
+	n[1] = node_find(hl, node->nw->ne, node->ne->nw, node->nw->se, node->ne->sw);
+	n[2] = node->ne;
+	n[3] = node_find(hl, node->nw->sw, node->nw->se, node->sw->nw, node->sw->ne);
+	n[4] = node_find(hl, node->nw->se, node->ne->sw, node->sw->ne, node->se->nw);
+	n[5] = node_find(hl, node->ne->sw, node->ne->se, node->se->nw, node->se->ne);
+	n[6] = node->sw;
+	n[7] = node_find(hl, node->sw->ne, node->se->nw, node->sw->se, node->se->sw);
+	n[8] = node->se;
+
+	fast = node->level - 2 == result_log;
+	for (i=0; i < 9; i++)
+		r[i] = fast ? hashlife_result(hl, n[i]) :
+			node_find(hl, n[i]->nw->se, n[i]->ne->sw, n[i]->sw->ne, n[i]->se->nw);
+
+	node->result = node_find(hl,
+		hashlife_result(hl, node_find(hl, r[0], r[1], r[3], r[4])),
+		hashlife_result(hl, node_find(hl, r[1], r[2], r[4], r[5])),
+		hashlife_result(hl, node_find(hl, r[3], r[4], r[6], r[7])),
+		hashlife_result(hl, node_find(hl, r[4], r[5], r[7], r[8])));
+
+	return node->result;
+}
+
+/*
+ * Function:	hashlife_expand
+ * ----------------------------
+ * Surround a node with empty space, doubling its size around its center.
+ *
+ * hl: the universe owning the node.
+ * node: the node being expanded.
+ *
+ * returns: pointer to the node one level above.
+ */
+static hl_node_t *hashlife_expand(hashlife_t *hl, hl_node_t *node)
+{
+	hl_node_t *e = node_empty(hl, node->level - 1);
+
+	return node_find(hl,
+		node_find(hl, e, e, e, node->nw),
+		node_find(hl, e, e, node->ne, e),
+		node_find(hl, e, node->sw, e, e),
+		node_find(hl, node->se, e, e, e));
+}
+
+/*
+ * Function:	hashlife_grow
+ * --------------------------
+ * Expand the root around its center, stopping the program when it would
+ * 	grow past HASHLIFE_MAX_LEVEL.
+ *
+ * hl: the universe being grown.
+ */
+static void hashlife_grow(hashlife_t *hl)
+{
+	if (hl->root->level >= HASHLIFE_MAX_LEVEL) {
+		fprintf(stderr, "hashlife_grow: The pattern outgrew a 2^%d universe\n", HASHLIFE_MAX_LEVEL);
+		exit(EXIT_FAILURE);
+	}
+
+	hl->root = hashlife_expand(hl, hl->root);
+}
+
+/*
+ * Function:	hashlife_centered
+ * ------------------------------
+ * Check if all of a node's cells are in its center quarter, the room its
+ * 	RESULT needs to hold the pattern after 2^(level - 3) generations.
+ *
+ * node: a node of level 3 or more.
+ *
+ * returns: 1 if the pattern fits, 0 otherwise.
+ */
+static int hashlife_centered(hl_node_t *node)
+{
+	return node->pop == node->nw->se->se->pop + node->ne->sw->sw->pop +
+		node->sw->ne->ne->pop + node->se->nw->nw->pop;
+}
+
+/*
+ * Function:	hashlife_build
+ * ---------------------------
+ * Build the node covering a square of the body.
+ *
+ * hl: the universe owning the node.
+ * body: the body holding the cells.
+ * level: the level of the node.
+ * x0: the column of the node's north-west corner.
+ * y0: the row of the node's north-west corner.
+ *
+ * returns: pointer to the canonical node.
+ */
+static hl_node_t *hashlife_build(hashlife_t *hl, const body_t *body, uint32_t level, int64_t x0, int64_t y0)
+{
+	int64_t half = (int64_t)1 << level >> 1;
+
+	if (x0 >= (int64_t)body->cols || y0 >= (int64_t)body->rows ||
+	    x0 + ((int64_t)1 << level) <= 0 || y0 + ((int64_t)1 << level) <= 0)
+		return node_empty(hl, level);
+
+	if (!level)
+		return &hl->leaf[BODY_GET(body, x0, y0)];
+
+	return node_find(hl,
+		hashlife_build(hl, body, level - 1, x0, y0),
+		hashlife_build(hl, body, level - 1, x0 + half, y0),
+		hashlife_build(hl, body, level - 1, x0, y0 + half),
+		hashlife_build(hl, body, level - 1, x0 + half, y0 + half));
+}
+
+/*
+ * Function:	hashlife_write
+ * ---------------------------
+ * Set the alive cells of a node that fall inside the body.
+ *
+ * node: the node being written.
+ * body: the body receiving the cells.
+ * x0: the column of the node's north-west corner.
+ * y0: the row of the node's north-west corner.
+ */
+static void hashlife_write(hl_node_t *node, body_t *body, int64_t x0, int64_t y0)
+{
+	int64_t half = (int64_t)1 << node->level >> 1;
+
+	if (!node->pop || x0 >= (int64_t)body->cols || y0 >= (int64_t)body->rows ||
+	    x0 + ((int64_t)1 << node->level) <= 0 || y0 + ((int64_t)1 << node->level) <= 0)
+		return;
+
+	if (!node->level) {
+		BODY_SET(body, x0, y0);
+		return;
+	}
+
+	hashlife_write(node->nw, body, x0, y0);
+	hashlife_write(node->ne, body, x0 + half, y0);
+	hashlife_write(node->sw, body, x0, y0 + half);
+	hashlife_write(node->se, body, x0 + half, y0 + half);
+}
+
+/*
+ * Function:	hashlife_load
+ * --------------------------
+ * Replace the universe with the cells of a body. The body's top left cell
+ * 	is placed at the origin. The root must hold every alive cell of the
+ * 	body, a cell dropped on the way is a bug and stops the program.
+ *
+ * hl: the universe being loaded.
+ * body: the body holding the cells.
+ */
+void hashlife_load(hashlife_t *hl, const body_t *body)
+{
+	uint32_t level = 3;
+
+	while (((int64_t)1 << (level - 1)) < (int64_t)body->rows ||
+	       ((int64_t)1 << (level - 1)) < (int64_t)body->cols)
+		level++;
+
+	hl->root = hashlife_build(hl, body, level, -((int64_t)1 << (level - 1)), -((int64_t)1 << (level - 1)));
+
+	if (hl->root->pop != body_population(body)) {
+		fprintf(stderr, "hashlife_load: Loaded %" PRIu64 " of %" PRIu64 " alive cells\n",
+				hl->root->pop, body_population(body));
+		exit(EXIT_FAILURE);
+	}
+}
+
+/*
+ * Function:	node_set
+ * ---------------------
+ * Get the node with one more alive cell, rebuilding the path down to it.
+ *
+ * hl: the universe owning the node.
+ * node: the node holding the cell.
+ * x: the column of the cell from the node's north-west corner.
+ * y: the row of the cell from the node's north-west corner.
+ *
+ * returns: pointer to the canonical node with the cell alive.
+ */
+static hl_node_t *node_set(hashlife_t *hl, hl_node_t *node, int64_t x, int64_t y)
+{
+	int64_t half = (int64_t)1 << node->level >> 1;
+
+	if (!node->level)
+		return &hl->leaf[1];
+
+	if (y < half)
+		return x < half ?
+			node_find(hl, node_set(hl, node->nw, x, y), node->ne, node->sw, node->se) :
+			node_find(hl, node->nw, node_set(hl, node->ne, x - half, y), node->sw, node->se);
+
+	return x < half ?
+		node_find(hl, node->nw, node->ne, node_set(hl, node->sw, x, y - half), node->se) :
+		node_find(hl, node->nw, node->ne, node->sw, node_set(hl, node->se, x - half, y - half));
+}
+
+/*
+ * Function:	hashlife_set
+ * -------------------------
+ * Make a cell alive, growing the root until it covers the cell. Seeding a
+ * 	pattern this way needs no body, however large the area it covers.
+ *
+ * hl: the universe.
+ * x: the column of the cell, the origin is the top left cell of the body.
+ * y: the row of the cell.
+ */
+void hashlife_set(hashlife_t *hl, int64_t x, int64_t y)
+{
+	int64_t half = (int64_t)1 << hl->root->level >> 1;
+
+	while (x < -half || x >= half || y < -half || y >= half) {
+		hashlife_grow(hl);
+		half = (int64_t)1 << hl->root->level >> 1;
+	}
+
+	hl->root = node_set(hl, hl->root, x + half, y + half);
+}
+
+/*
+ * Function:	hashlife_step
+ * --------------------------
+ * Advance the universe 2^step_log generations. The root is expanded until
+ * 	it is large enough for the step and the pattern cannot reach its
+ * 	edges, then replaced with its RESULT. A pattern that would need a
+ * 	root past HASHLIFE_MAX_LEVEL stops the program. The cache is only
+ * 	collected between steps, so a single step may grow it past its size.
+ *
+ * hl: the universe being advanced.
+ * step_log: log2 of the number of generations.
+ */
+void hashlife_step(hashlife_t *hl, unsigned step_log)
+{
+	hl->step_log = step_log;
+
+	if (hl->nodes > hl->max_nodes)
+		hashlife_gc(hl);
+
+	while (hl->root->level < step_log + 3 || !hashlife_centered(hl->root))
+		hashlife_grow(hl);
+
+	hl->root = hashlife_result(hl, hl->root);
+}
+
+/*
+ * Function:	hashlife_read
+ * --------------------------
+ * Copy the part of the universe covered by a body into the body.
+ *
+ * hl: the universe being read.
+ * body: the body receiving the cells, its top left cell is the origin.
+ */
+void hashlife_read(hashlife_t *hl, body_t *body)
+{
+	int64_t half = (int64_t)1 << hl->root->level >> 1;
+
+	body_clear(body);
+	hashlife_write(hl->root, body, -half, -half);
+}
+
+/*
+ * Function:	hashlife_population
+ * --------------------------------
+ * Get the population of the whole universe.
+ *
+ * hl: the universe.
+ *
+ * returns: the number of alive cells.
+ */
+uint64_t hashlife_population(hashlife_t *hl)
+{
+	return hl->root->pop;
+}
@@ -0,0 +1,1073 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "cell.h"
+#include "kernel.h"
+#include "rule.h"
+
+/*
+ * Function:	compute_word
+ * -------------------------
+ * Apply the rules of the game of life to 64 cells at once. Each argument
+ * 	is a word of cells aligned with the center word, i.e. aw holds the
+ * 	north-west neighbor of every cell in c. The eight neighbor words are
+ * 	summed with bitwise full adders, a cell is alive in the next
+ * 	generation when its neighbor count is 3, or 2 and it is alive.
+ *
+ * aw, a, ae: the north-west, north, and north-east neighbor words.
+ * w, c, e: the west neighbor, center, and east neighbor words.
+ * bw, b, be: the south-west, south, and south-east neighbor words.
+ *
+ * returns: the next generation of the center word.
+ */
+static inline uint64_t compute_word(uint64_t aw, uint64_t a, uint64_t ae,
+		uint64_t w, uint64_t c, uint64_t e, uint64_t bw, uint64_t b, uint64_t be)
+{
+	uint64_t a0, a1, b0, b1, m0, m1, s0, s1, x, xa, y, ya;
+
+	/* Count each row, the counts are 2 bits wide */
+	a0 = aw ^ a ^ ae;
+	a1 = (aw & a) | (ae & (aw ^ a));
+	b0 = bw ^ b ^ be;
+	b1 = (bw & b) | (be & (bw ^ b));
+	m0 = w ^ e;
+	m1 = w & e;
+
+	/* Sum the ones, carrying into the twos */
+	s0 = a0 ^ b0 ^ m0;
+	s1 = (a0 & b0) | (m0 & (a0 ^ b0));
+
+	/* The count is 2 or 3 when exactly one of the twos is set */
+	x = a1 ^ b1;
+	xa = a1 & b1;
+	y = m1 ^ s1;
+	ya = m1 & s1;
+
+	return (x ^ y) & ~(xa | ya) & (s0 | c);
+}
+
+/*
+ * Function:	compute_words
+ * --------------------------
+ * Compute a run of words of one row. The rows are read one word past
+ * 	either end of the run, which at the body's edges is the halo.
+ *
+ * out: the row of the new body being written.
+ * above: the row above in the old body.
+ * row: the row in the old body.
+ * below: the row below in the old body.
+ * start: the first word to compute.
+ * end: one past the last word to compute.
+ */
+static void compute_words(uint64_t *out, const uint64_t *above, const uint64_t *row,
+		const uint64_t *below, size_t start, size_t end)
+{
+	size_t i;
+	uint64_t n[3], c[3], s[3];
+
+#define LOAD3(dst, src) do { \
+		dst[0] = (src)[i - 1]; \
+		dst[1] = (src)[i]; \
+		dst[2] = (src)[i + 1]; \
+	} while (0)
+#define WEST(v) ((v[1] << 1) | (v[0] >> (BODY_WORD_BITS - 1)))
+#define EAST(v) ((v[1] >> 1) | (v[2] << (BODY_WORD_BITS - 1)))
+
+	for (i=start; i < end; i++) {
+		LOAD3(n, above);
+		LOAD3(c, row);
+		LOAD3(s, below);
+
+		out[i] = compute_word(WEST(n), n[1], EAST(n), WEST(c), c[1], EAST(c), WEST(s), s[1], EAST(s));
+	}
+
+#undef LOAD3
+#undef WEST
+#undef EAST
+}
+
+/*
+ * Function:	finish_row
+ * -----------------------
+ * Clear the cells past the last column of a computed run of words, then
+ * 	count its population and note whether it differs from the old row.
+ * 	A wrapped halo sets the bit past the last column of the old row, it
+ * 	is left out of the comparison.
+ *
+ * body: the body the rows belong to.
+ * out: the row of the new body that was computed.
+ * row: the row in the old body.
+ * start: the first word computed.
+ * end: one past the last word computed.
+ * diff: accumulates the bits that changed.
+ *
+ * returns: the population of the run.
+ */
+static inline uint64_t finish_row(const body_t *body, uint64_t *out, const uint64_t *row,
+		size_t start, size_t end, uint64_t *diff)
+{
+	size_t i, last = end;
+	uint64_t pop = 0, mask;
+
+	if (end == body->words) {
+		last = end - 1;
+		mask = BODY_TAIL_MASK(body);
+		out[last] &= mask;
+		pop += __builtin_popcountll(out[last]);
+		*diff |= out[last] ^ (row[last] & mask);
+	}
+
+	for (i=start; i < last; i++) {
+		pop += __builtin_popcountll(out[i]);
+		*diff |= out[i] ^ row[i];
+	}
+
+	return pop;
+}
+
+/*
+ * Function:	scalar_compute
+ * ---------------------------
+ * The portable kernel, computes a span of the body one word at a time.
+ *
+ * body_new: pointer to the body that will store the updated cells.
+ * body_old: pointer to the body that stores the previous generation of cells.
+ * span: the rows and words to compute.
+ * changed: set to 1 if any cell of the span changed, 0 otherwise.
+ *
+ * returns: the population of the span.
+ */
+static uint64_t scalar_compute(body_t *body_new, const body_t *body_old, const span_t *span, int *changed)
+{
+	size_t y;
+	const uint64_t *row;
+	uint64_t *out, pop = 0, diff = 0;
+
+	for (y=span->row_start; y < span->row_end; y++) {
+		row = BODY_ROW(body_old, y);
+		out = BODY_ROW(body_new, y);
+		compute_words(out, BODY_ROW(body_old, y - 1), row, BODY_ROW(body_old, y + 1),
+				span->word_start, span->word_end);
+		pop += finish_row(body_old, out, row, span->word_start, span->word_end, &diff);
+	}
+
+	*changed = diff != 0;
+	return pop;
+}
+
+static int scalar_supported(void)
+{
+	return 1;
+}
+
+/*
+ * Function:	count_word
+ * -----------------------
+ * Sum the neighbors of 64 cells at once into a 4 bit count with the same
+ * 	full adders as compute_word.
+ *
+ * aw, a, ae: the north-west, north, and north-east neighbor words.
+ * w, e: the west and east neighbor words.
+ * bw, b, be: the south-west, south, and south-east neighbor words.
+ * count: set to the bits of the count, count[i] holds bit i.
+ */
+static inline __attribute__((always_inline)) void count_word(uint64_t aw, uint64_t a, uint64_t ae,
+		uint64_t w, uint64_t e, uint64_t bw, uint64_t b, uint64_t be, uint64_t count[4])
+{
+	uint64_t a0, a1, b0, b1, m0, m1, c0, p, pc, q, qc, u;
+
+	/* Count each row, the counts are 2 bits wide */
+	a0 = aw ^ a ^ ae;
+	a1 = (aw & a) | (ae & (aw ^ a));
+	b0 = bw ^ b ^ be;
+	b1 = (bw & b) | (be & (bw ^ b));
+	m0 = w ^ e;
+	m1 = w & e;
+
+	/* Sum the ones, carrying into the twos */
+	count[0] = a0 ^ b0 ^ m0;
+	c0 = (a0 & b0) | (m0 & (a0 ^ b0));
+
+	/* Sum the twos, carrying into the fours and eights */
+	p = a1 ^ b1;
+	pc = a1 & b1;
+	q = m1 ^ c0;
+	qc = m1 & c0;
+	count[1] = p ^ q;
+	u = p & q;
+	count[2] = pc ^ qc ^ u;
+	count[3] = (pc & qc) | (u & (pc ^ qc));
+}
+
+/*
+ * Function:	count_match
+ * ------------------------
+ * Select the cells whose count is one of a set of counts.
+ *
+ * count: the bits of the counts, see count_word.
+ * counts: bit n is set to select the cells with a count of n.
+ *
+ * returns: the word of the selected cells.
+ */
+static inline __attribute__((always_inline)) uint64_t count_match(const uint64_t count[4], uint16_t counts)
+{
+	uint64_t eq, match = 0;
+	int n;
+
+	for (n=0; n <= 8; n++) {
+		eq = (n & 1 ? count[0] : ~count[0]) & (n & 2 ? count[1] : ~count[1]) &
+			(n & 4 ? count[2] : ~count[2]) & (n & 8 ? count[3] : ~count[3]);
+		match |= eq & -(uint64_t)(counts >> n & 1);
+	}
+
+	return match;
+}
+
+/*
+ * Function:	rule_word
+ * ----------------------
+ * Apply any outer-totalistic rule to 64 cells at once. Always inlined so
+ * 	constant masks fold into a dedicated expression.
+ *
+ * aw, a, ae: the north-west, north, and north-east neighbor words.
+ * w, c, e: the west neighbor, center, and east neighbor words.
+ * bw, b, be: the south-west, south, and south-east neighbor words.
+ * birth: the counts a dead cell is born with.
+ * survive: the counts an alive cell survives with.
+ *
+ * returns: the next generation of the center word.
+ */
+static inline __attribute__((always_inline)) uint64_t rule_word(uint64_t aw, uint64_t a, uint64_t ae,
+		uint64_t w, uint64_t c, uint64_t e, uint64_t bw, uint64_t b, uint64_t be,
+		uint16_t birth, uint16_t survive)
+{
+	uint64_t count[4];
+
+	count_word(aw, a, ae, w, e, bw, b, be, count);
+	return (c & count_match(count, survive)) | (~c & count_match(count, birth));
+}
+
+/*
+ * Function:	rule_words
+ * -----------------------
+ * Compute a run of words of one row with rule_word, see compute_words.
+ *
+ * out: the row of the new body being written.
+ * above: the row above in the old body.
+ * row: the row in the old body.
+ * below: the row below in the old body.
+ * start: the first word to compute.
+ * end: one past the last word to compute.
+ * birth: the counts a dead cell is born with.
+ * survive: the counts an alive cell survives with.
+ */
+static inline __attribute__((always_inline)) void rule_words(uint64_t *out, const uint64_t *above,
+		const uint64_t *row, const uint64_t *below, size_t start, size_t end,
+		uint16_t birth, uint16_t survive)
+{
+	size_t i;
+	uint64_t n[3], c[3], s[3];
+
+#define LOAD3(dst, src) do { \
+		dst[0] = (src)[i - 1]; \
+		dst[1] = (src)[i]; \
+		dst[2] = (src)[i + 1]; \
+	} while (0)
+#define WEST(v) ((v[1] << 1) | (v[0] >> (BODY_WORD_BITS - 1)))
+#define EAST(v) ((v[1] >> 1) | (v[2] << (BODY_WORD_BITS - 1)))
+
+	for (i=start; i < end; i++) {
+		LOAD3(n, above);
+		LOAD3(c, row);
+		LOAD3(s, below);
+
+		out[i] = rule_word(WEST(n), n[1], EAST(n), WEST(c), c[1], EAST(c), WEST(s), s[1], EAST(s),
+				birth, survive);
+	}
+
+#undef LOAD3
+#undef WEST
+#undef EAST
+}
+
+/* A run of words specialized for one rule, the masks are constants */
+#define RULE_WORDS(name, birth, survive) \
+	static void name(uint64_t *out, const uint64_t *above, const uint64_t *row, \
+			const uint64_t *below, size_t start, size_t end) \
+	{ \
+		rule_words(out, above, row, below, start, end, birth, survive); \
+	}
+
+RULE_WORDS(highlife_words, RULE_N(3) | RULE_N(6), RULE_N(2) | RULE_N(3))
+RULE_WORDS(day_and_night_words, RULE_N(3) | RULE_N(6) | RULE_N(7) | RULE_N(8),
+		RULE_N(3) | RULE_N(4) | RULE_N(6) | RULE_N(7) | RULE_N(8))
+RULE_WORDS(seeds_words, RULE_N(2), 0)
+RULE_WORDS(life_without_death_words, RULE_N(3), 0x1FF)
+RULE_WORDS(maze_words, RULE_N(3), RULE_N(1) | RULE_N(2) | RULE_N(3) | RULE_N(4) | RULE_N(5))
+RULE_WORDS(replicator_words, RULE_N(1) | RULE_N(3) | RULE_N(5) | RULE_N(7),
+		RULE_N(1) | RULE_N(3) | RULE_N(5) | RULE_N(7))
+
+/*
+ * Function:	generic_words
+ * --------------------------
+ * Compute a run of words with the masks of the selected rule, for the
+ * 	rules without a dedicated run.
+ */
+static void generic_words(uint64_t *out, const uint64_t *above, const uint64_t *row,
+		const uint64_t *below, size_t start, size_t end)
+{
+	rule_words(out, above, row, below, start, end, rule.birth, rule.survive);
+}
+
+/* Rules with a dedicated run of words, B3/S23 keeps its own adder network */
+static const struct rule_kernel {
+	uint16_t birth;
+	uint16_t survive;
+	rule_words_t words;
+} rule_kernels[] = {
+	{ RULE_CONWAY_BIRTH, RULE_CONWAY_SURVIVE, compute_words },
+	{ RULE_N(3) | RULE_N(6), RULE_N(2) | RULE_N(3), highlife_words },
+	{ RULE_N(3) | RULE_N(6) | RULE_N(7) | RULE_N(8),
+		RULE_N(3) | RULE_N(4) | RULE_N(6) | RULE_N(7) | RULE_N(8), day_and_night_words },
+	{ RULE_N(2), 0, seeds_words },
+	{ RULE_N(3), 0x1FF, life_without_death_words },
+	{ RULE_N(3), RULE_N(1) | RULE_N(2) | RULE_N(3) | RULE_N(4) | RULE_N(5), maze_words },
+	{ RULE_N(1) | RULE_N(3) | RULE_N(5) | RULE_N(7),
+		RULE_N(1) | RULE_N(3) | RULE_N(5) | RULE_N(7), replicator_words },
+	{ 0, 0, NULL }
+};
+
+/* The run of words of the selected rule, see rule_init */
+static rule_words_t rule_run;
+
+/*
+ * Function:	rule_init
+ * ----------------------
+ * Select the dedicated run of words of the rule, or the generic one.
+ */
+static void rule_init(void)
+{
+	const struct rule_kernel *k;
+
+	rule_run = generic_words;
+	for (k=rule_kernels; k->words; k++)
+		if (k->birth == rule.birth && k->survive == rule.survive)
+			rule_run = k->words;
+}
+
+/*
+ * Function:	rule_compute
+ * -------------------------
+ * Portable kernel for any outer-totalistic rule, computes a span of the
+ * 	body one word at a time with the run selected by rule_init.
+ *
+ * body_new: pointer to the body that will store the updated cells.
+ * body_old: pointer to the body that stores the previous generation of cells.
+ * span: the rows and words to compute.
+ * changed: set to 1 if any cell of the span changed, 0 otherwise.
+ *
+ * returns: the population of the span.
+ */
+static uint64_t rule_compute(body_t *body_new, const body_t *body_old, const span_t *span, int *changed)
+{
+	size_t y;
+	const uint64_t *row;
+	uint64_t *out, pop = 0, diff = 0;
+
+	for (y=span->row_start; y < span->row_end; y++) {
+		row = BODY_ROW(body_old, y);
+		out = BODY_ROW(body_new, y);
+		rule_run(out, BODY_ROW(body_old, y - 1), row, BODY_ROW(body_old, y + 1),
+				span->word_start, span->word_end);
+		pop += finish_row(body_old, out, row, span->word_start, span->word_end, &diff);
+	}
+
+	*changed = diff != 0;
+	return pop;
+}
+
+/*
+ * Function:	generations_span
+ * -----------------------------
+ * Compute a span of the body under a Generations rule one word at a time.
+ * 	The alive cells follow the rule like rule_compute except dying cells
+ * 	cannot be born, the decay planes are a bit-sliced counter that starts
+ * 	at 1 when an alive cell does not survive and is incremented until it
+ * 	wraps to dead after states - 2. Always inlined like rule_words.
+ *
+ * body_new: pointer to the body that will store the updated cells.
+ * body_old: pointer to the body that stores the previous generation of cells.
+ * span: the rows and words to compute.
+ * changed: set to 1 if any cell of the span changed, 0 otherwise.
+ * birth: the counts a dead cell is born with.
+ * survive: the counts an alive cell survives with.
+ * states: the number of states.
+ * planes: the number of decay planes.
+ *
+ * returns: the population of the span.
+ */
+static inline __attribute__((always_inline)) uint64_t generations_span(body_t *body_new,
+		const body_t *body_old, const span_t *span, int *changed,
+		uint16_t birth, uint16_t survive, uint16_t states, size_t planes)
+{
+	size_t y, i, p;
+	const uint64_t *above, *row, *below, *decay[RULE_PLANES_MAX];
+	uint64_t *out, *decay_new[RULE_PLANES_MAX];
+	uint64_t n[3], c[3], s[3], count[4], d[RULE_PLANES_MAX];
+	uint64_t dying, last, survived, step, carry, next;
+	uint64_t pop = 0, diff = 0, tail = BODY_TAIL_MASK(body_old);
+	uint16_t max = states - 2;
+
+#define LOAD3(dst, src) do { \
+		dst[0] = (src)[i - 1]; \
+		dst[1] = (src)[i]; \
+		dst[2] = (src)[i + 1]; \
+	} while (0)
+#define WEST(v) ((v[1] << 1) | (v[0] >> (BODY_WORD_BITS - 1)))
+#define EAST(v) ((v[1] >> 1) | (v[2] << (BODY_WORD_BITS - 1)))
+
+	for (y=span->row_start; y < span->row_end; y++) {
+		above = BODY_ROW(body_old, y - 1);
+		row = BODY_ROW(body_old, y);
+		below = BODY_ROW(body_old, y + 1);
+		out = BODY_ROW(body_new, y);
+		for (p=0; p < planes; p++) {
+			decay[p] = BODY_PLANE_ROW(body_old, p, y);
+			decay_new[p] = BODY_PLANE_ROW(body_new, p, y);
+		}
+
+		for (i=span->word_start; i < span->word_end; i++) {
+			LOAD3(n, above);
+			LOAD3(c, row);
+			LOAD3(s, below);
+			count_word(WEST(n), n[1], EAST(n), WEST(c), EAST(c), WEST(s), s[1], EAST(s), count);
+
+			dying = 0;
+			last = ~(uint64_t)0;
+			for (p=0; p < planes; p++) {
+				d[p] = decay[p][i];
+				dying |= d[p];
+				last &= max >> p & 1 ? d[p] : ~d[p];
+			}
+
+			survived = c[1] & count_match(count, survive);
+			out[i] = survived | (~c[1] & ~dying & count_match(count, birth));
+
+			/* Count up the dying cells and the ones that just died */
+			step = (dying & ~last) | (c[1] & ~survived);
+			if (i == body_old->words - 1)
+				step &= tail;
+			carry = ~(uint64_t)0;
+			for (p=0; p < planes; p++) {
+				next = (d[p] ^ carry) & step;
+				carry &= d[p];
+				diff |= next ^ d[p];
+				decay_new[p][i] = next;
+			}
+		}
+
+		pop += finish_row(body_old, out, row, span->word_start, span->word_end, &diff);
+	}
+
+#undef LOAD3
+#undef WEST
+#undef EAST
+
+	*changed = diff != 0;
+	return pop;
+}
+
+/* A Generations kernel specialized for one rule, the masks are constants */
+#define GENERATIONS_COMPUTE(name, birth, survive, states, planes) \
+	static uint64_t name(body_t *body_new, const body_t *body_old, const span_t *span, int *changed) \
+	{ \
+		return generations_span(body_new, body_old, span, changed, birth, survive, states, planes); \
+	}
+
+GENERATIONS_COMPUTE(brians_brain_compute, RULE_N(2), 0, 3, 1)
+GENERATIONS_COMPUTE(star_wars_compute, RULE_N(2), RULE_N(3) | RULE_N(4) | RULE_N(5), 4, 2)
+
+/*
+ * Function:	generations_generic
+ * --------------------------------
+ * Compute a span with the masks of the selected Generations rule, for the
+ * 	rules without a dedicated kernel.
+ */
+static uint64_t generations_generic(body_t *body_new, const body_t *body_old, const span_t *span, int *changed)
+{
+	return generations_span(body_new, body_old, span, changed, rule.birth, rule.survive,
+			rule.states, body_old->planes);
+}
+
+/* Generations rules with a dedicated kernel */
+static const struct generations_kernel {
+	uint16_t birth;
+	uint16_t survive;
+	uint16_t states;
+	uint64_t (*compute)(body_t *body_new, const body_t *body_old, const span_t *span, int *changed);
+} generations_kernels[] = {
+	{ RULE_N(2), 0, 3, brians_brain_compute },
+	{ RULE_N(2), RULE_N(3) | RULE_N(4) | RULE_N(5), 4, star_wars_compute },
+	{ 0, 0, 0, NULL }
+};
+
+/* The kernel of the selected Generations rule, see generations_init */
+static uint64_t (*generations_run)(body_t *body_new, const body_t *body_old, const span_t *span, int *changed);
+
+/*
+ * Function:	generations_init
+ * -----------------------------
+ * Select the dedicated kernel of the Generations rule, or the generic one.
+ */
+static void generations_init(void)
+{
+	const struct generations_kernel *k;
+
+	generations_run = generations_generic;
+	for (k=generations_kernels; k->compute; k++)
+		if (k->birth == rule.birth && k->survive == rule.survive && k->states == rule.states)
+			generations_run = k->compute;
+}
+
+/*
+ * Function:	generations_compute
+ * --------------------------------
+ * Kernel for Generations rules, runs the kernel selected by generations_init.
+ *
+ * body_new: pointer to the body that will store the updated cells.
+ * body_old: pointer to the body that stores the previous generation of cells.
+ * span: the rows and words to compute.
+ * changed: set to 1 if any cell of the span changed, 0 otherwise.
+ *
+ * returns: the population of the span.
+ */
+static uint64_t generations_compute(body_t *body_new, const body_t *body_old, const span_t *span, int *changed)
+{
+	return generations_run(body_new, body_old, span, changed);
+}
+
+/*
+ * Function:	ltl_compute
+ * ------------------------
+ * Kernel for Larger than Life rules. The span keeps a running sum of each
+ * 	column over the 2 * radius + 1 rows around the current row, slid down
+ * 	one row at a time, and each cell's count is a running sum of those
+ * 	column sums slid across the row, so the cost of a cell does not grow
+ * 	with the radius. The halo is as wide as the radius.
+ *
+ * body_new: pointer to the body that will store the updated cells.
+ * body_old: pointer to the body that stores the previous generation of cells.
+ * span: the rows and words to compute.
+ * changed: set to 1 if any cell of the span changed, 0 otherwise.
+ *
+ * returns: the population of the span.
+ */
+static uint64_t ltl_compute(body_t *body_new, const body_t *body_old, const span_t *span, int *changed)
+{
+	ptrdiff_t x, y, r = rule.radius;
+	ptrdiff_t x_start = span->word_start * BODY_WORD_BITS;
+	ptrdiff_t x_end = span->word_end == body_old->words ? (ptrdiff_t)body_old->cols : (ptrdiff_t)span->word_end * BODY_WORD_BITS;
+	ptrdiff_t x0 = x_start - r, x1 = x_end + r; /* sums[x - x0] is the sum of column x */
+	uint16_t sums[LTL_SUMS_MAX];
+	unsigned sum, count;
+	unsigned min[2] = { rule.birth_min, rule.survive_min }; /* indexed by the cell */
+	unsigned width[2] = { rule.birth_max - rule.birth_min, rule.survive_max - rule.survive_min };
+	size_t i;
+	const uint64_t *row, *in, *gone;
+	uint64_t *out, word, alive, pop = 0, diff = 0;
+
+	memset(sums, 0, (x1 - x0) * sizeof(*sums));
+	for (y=(ptrdiff_t)span->row_start - r; y <= (ptrdiff_t)span->row_start + r; y++) {
+		in = BODY_ROW(body_old, y);
+		for (x=x0; x < x1; x++)
+			sums[x - x0] += BODY_ROW_GET(in, x);
+	}
+
+	for (y=span->row_start; y < (ptrdiff_t)span->row_end; y++) {
+		if (y > (ptrdiff_t)span->row_start) { /* Slide the column sums down a row */
+			in = BODY_ROW(body_old, y + r);
+			gone = BODY_ROW(body_old, y - r - 1);
+			for (x=x0; x < x1; x++)
+				sums[x - x0] += BODY_ROW_GET(in, x) - BODY_ROW_GET(gone, x);
+		}
+
+		row = BODY_ROW(body_old, y);
+		out = BODY_ROW(body_new, y);
+		sum = 0;
+		for (x=0; x < 2 * r; x++)
+			sum += sums[x];
+
+		for (i=span->word_start; i < span->word_end; i++) {
+			word = 0;
+			for (x=i * BODY_WORD_BITS; x < (ptrdiff_t)(i + 1) * BODY_WORD_BITS && x < x_end; x++) {
+				sum += sums[x + r - x0];
+				alive = (row[i] >> (x % BODY_WORD_BITS)) & 1;
+				count = sum - (rule.middle ? 0 : alive);
+				word |= (uint64_t)(count - min[alive] <= width[alive]) << (x % BODY_WORD_BITS);
+				sum -= sums[x - r - x0];
+			}
+			out[i] = word;
+		}
+
+		pop += finish_row(body_old, out, row, span->word_start, span->word_end, &diff);
+	}
+
+	*changed = diff != 0;
+	return pop;
+}
+
+/*
+ * Function:	colsum_compute
+ * ---------------------------
+ * Portable kernel computing one cell at a time from sums of columns of
+ * 	three cells. The sums of the west and center columns of a cell are
+ * 	the center and east sums of its west neighbor, so every cell reads
+ * 	three cells, its east column, instead of its nine.
+ *
+ * body_new: pointer to the body that will store the updated cells.
+ * body_old: pointer to the body that stores the previous generation of cells.
+ * span: the rows and words to compute.
+ * changed: set to 1 if any cell of the span changed, 0 otherwise.
+ *
+ * returns: the population of the span.
+ */
+static uint64_t colsum_compute(body_t *body_new, const body_t *body_old, const span_t *span, int *changed)
+{
+	size_t y, i, j;
+	ptrdiff_t x;
+	const uint64_t *above, *row, *below;
+	uint64_t *out, a, c, b, word, pop = 0, diff = 0;
+	unsigned west, center, east, alive;
+	uint16_t next[2] = { rule.birth, rule.survive }; /* indexed by the cell */
+
+	for (y=span->row_start; y < span->row_end; y++) {
+		above = BODY_ROW(body_old, (ptrdiff_t)y - 1);
+		row = BODY_ROW(body_old, y);
+		below = BODY_ROW(body_old, y + 1);
+		out = BODY_ROW(body_new, y);
+
+		/* The columns west of the first cell and of the first cell */
+		x = span->word_start * BODY_WORD_BITS;
+		west = BODY_ROW_GET(above, x - 1) + BODY_ROW_GET(row, x - 1) + BODY_ROW_GET(below, x - 1);
+		center = BODY_ROW_GET(above, x) + BODY_ROW_GET(row, x) + BODY_ROW_GET(below, x);
+
+		for (i=span->word_start; i < span->word_end; i++) {
+			/* Bit j holds the column east of cell j */
+			a = (above[i] >> 1) | (above[i + 1] << (BODY_WORD_BITS - 1));
+			c = (row[i] >> 1) | (row[i + 1] << (BODY_WORD_BITS - 1));
+			b = (below[i] >> 1) | (below[i + 1] << (BODY_WORD_BITS - 1));
+
+			word = 0;
+			for (j=0; j < BODY_WORD_BITS; j++) {
+				east = (a >> j & 1) + (c >> j & 1) + (b >> j & 1);
+				alive = row[i] >> j & 1;
+				word |= (uint64_t)(next[alive] >> (west + center + east - alive) & 1) << j;
+				west = center;
+				center = east;
+			}
+			out[i] = word;
+		}
+
+		pop += finish_row(body_old, out, row, span->word_start, span->word_end, &diff);
+	}
+
+	*changed = diff != 0;
+	return pop;
+}
+
+/* Next state of every 3x3 block, see isotropic_init */
+static uint8_t isotropic_table[ISOTROPIC_ENTRIES];
+
+/*
+ * Function:	isotropic_init
+ * ---------------------------
+ * Build the lookup table of the isotropic kernel. The index holds a 3x3
+ * 	block, the row above in bits 8 to 6, the row of the cell in bits 5
+ * 	to 3 and the row below in bits 2 to 0, the west cell of a row in the
+ * 	highest bit. The entry holds the next state of the center cell.
+ */
+static void isotropic_init(void)
+{
+	/* Bit of the block holding neighbor i in N, NE, E, SE, S, SW, W, NW order */
+	static const int neighbor_bits[8] = { 7, 6, 3, 0, 1, 2, 5, 8 };
+	int block, alive, i;
+	unsigned neighbors;
+
+	for (block=0; block < ISOTROPIC_ENTRIES; block++) {
+		alive = (block >> 4) & 1;
+		neighbors = 0;
+		for (i=0; i < 8; i++)
+			neighbors |= ((block >> neighbor_bits[i]) & 1) << i;
+
+		if (rule.isotropic)
+			isotropic_table[block] = RULE_NEXT_CASE(rule, alive, neighbors);
+		else
+			isotropic_table[block] = RULE_NEXT(rule, alive, __builtin_popcount(neighbors));
+	}
+}
+
+/*
+ * Function:	isotropic_compute
+ * ------------------------------
+ * Table driven kernel for rules that tell apart the arrangements of the
+ * 	neighbors. The 3x3 block of a cell is built from the block of its west
+ * 	neighbor by shifting in the next column, so every cell costs one
+ * 	lookup in isotropic_table.
+ *
+ * body_new: pointer to the body that will store the updated cells.
+ * body_old: pointer to the body that stores the previous generation of cells.
+ * span: the rows and words to compute.
+ * changed: set to 1 if any cell of the span changed, 0 otherwise.
+ *
+ * returns: the population of the span.
+ */
+static uint64_t isotropic_compute(body_t *body_new, const body_t *body_old, const span_t *span, int *changed)
+{
+	size_t y, i, j;
+	ptrdiff_t x;
+	const uint64_t *above, *row, *below;
+	uint64_t *out, a, c, b, word, pop = 0, diff = 0;
+	unsigned block;
+
+	for (y=span->row_start; y < span->row_end; y++) {
+		above = BODY_ROW(body_old, (ptrdiff_t)y - 1);
+		row = BODY_ROW(body_old, y);
+		below = BODY_ROW(body_old, y + 1);
+		out = BODY_ROW(body_new, y);
+
+		/* The columns west of the first cell and of the first cell */
+		x = span->word_start * BODY_WORD_BITS;
+		block = BODY_ROW_GET(above, x - 1) << 7 | BODY_ROW_GET(row, x - 1) << 4 | BODY_ROW_GET(below, x - 1) << 1 |
+			BODY_ROW_GET(above, x) << 6 | BODY_ROW_GET(row, x) << 3 | BODY_ROW_GET(below, x);
+
+		for (i=span->word_start; i < span->word_end; i++) {
+			/* Bit j holds the column east of cell j */
+			a = (above[i] >> 1) | (above[i + 1] << (BODY_WORD_BITS - 1));
+			c = (row[i] >> 1) | (row[i + 1] << (BODY_WORD_BITS - 1));
+			b = (below[i] >> 1) | (below[i + 1] << (BODY_WORD_BITS - 1));
+
+			word = 0;
+			for (j=0; j < BODY_WORD_BITS; j++) {
+				block = (block << 1 & 0x1B6) | (a >> j & 1) << 6 | (c >> j & 1) << 3 | (b >> j & 1);
+				word |= (uint64_t)isotropic_table[block] << j;
+			}
+			out[i] = word;
+		}
+
+		pop += finish_row(body_old, out, row, span->word_start, span->word_end, &diff);
+	}
+
+	*changed = diff != 0;
+	return pop;
+}
+
+/* Next 2x2 center of every 4x4 block, see lut_init */
+static uint8_t lut[LUT_ENTRIES];
+
+/*
+ * Function:	lut_init
+ * ---------------------
+ * Build the lookup table of the lut kernel. The index holds a 4x4 block,
+ * 	bit r * 4 + c for row r and column c, the entry holds the next
+ * 	generation of its center 2x2 cells, bit r * 2 + c for the center row
+ * 	r and column c.
+ */
+static void lut_init(void)
+{
+	int block, r, c, a, b, alive, neighbors;
+
+	for (block=0; block < LUT_ENTRIES; block++) {
+		lut[block] = 0;
+		for (r=1; r < 3; r++) {
+			for (c=1; c < 3; c++) {
+				alive = (block >> (r * 4 + c)) & 1;
+				neighbors = -alive;
+				for (b=-1; b < 2; b++)
+					for (a=-1; a < 2; a++)
+						neighbors += (block >> ((r + b) * 4 + c + a)) & 1;
+
+				if (RULE_NEXT(rule, alive, neighbors))
+					lut[block] |= 1 << ((r - 1) * 2 + c - 1);
+			}
+		}
+	}
+}
+
+/*
+ * Function:	lut_compute
+ * ------------------------
+ * Portable table driven kernel, computes the span two rows and two columns
+ * 	at a time by looking up the 4x4 block around each 2x2 square of cells.
+ *
+ * body_new: pointer to the body that will store the updated cells.
+ * body_old: pointer to the body that stores the previous generation of cells.
+ * span: the rows and words to compute.
+ * changed: set to 1 if any cell of the span changed, 0 otherwise.
+ *
+ * returns: the population of the span.
+ */
+static uint64_t lut_compute(body_t *body_new, const body_t *body_old, const span_t *span, int *changed)
+{
+	size_t y, i, j, r;
+	const uint64_t *rows[4];
+	uint64_t *out[2], lo[4], hi[4], result[2], pop = 0, diff = 0;
+	uint8_t next;
+	unsigned block;
+
+	for (y=span->row_start; y < span->row_end; y += 2) {
+		/* An odd last row reads the halo row twice, only its first row is kept */
+		rows[0] = BODY_ROW(body_old, y - 1);
+		rows[1] = BODY_ROW(body_old, y);
+		rows[2] = BODY_ROW(body_old, y + 1);
+		rows[3] = BODY_ROW(body_old, y + 2 <= body_old->rows ? y + 2 : y + 1);
+		out[0] = BODY_ROW(body_new, y);
+		out[1] = y + 1 < span->row_end ? BODY_ROW(body_new, y + 1) : NULL;
+
+		for (i=span->word_start; i < span->word_end; i++) {
+			/* lo: cells x - 1 to x + 62, hi: cells x + 63 and x + 64 */
+			for (r=0; r < 4; r++) {
+				lo[r] = (rows[r][i] << 1) | (rows[r][i - 1] >> (BODY_WORD_BITS - 1));
+				hi[r] = (rows[r][i] >> (BODY_WORD_BITS - 1)) | (rows[r][i + 1] & 1) << 1;
+			}
+
+			result[0] = result[1] = 0;
+			for (j=0; j < BODY_WORD_BITS / 2 - 1; j++) {
+				block = ((lo[0] >> (2 * j)) & 0xF) | ((lo[1] >> (2 * j)) & 0xF) << 4 |
+					((lo[2] >> (2 * j)) & 0xF) << 8 | ((lo[3] >> (2 * j)) & 0xF) << 12;
+				next = lut[block];
+				result[0] |= (uint64_t)(next & 3) << (2 * j);
+				result[1] |= (uint64_t)(next >> 2) << (2 * j);
+			}
+
+			/* The last pair of columns reaches into the next word */
+			block = ((lo[0] >> (2 * j)) | (hi[0] << 2)) | ((lo[1] >> (2 * j)) | (hi[1] << 2)) << 4 |
+				((lo[2] >> (2 * j)) | (hi[2] << 2)) << 8 | ((lo[3] >> (2 * j)) | (hi[3] << 2)) << 12;
+			next = lut[block];
+			result[0] |= (uint64_t)(next & 3) << (2 * j);
+			result[1] |= (uint64_t)(next >> 2) << (2 * j);
+
+			out[0][i] = result[0];
+			if (out[1])
+				out[1][i] = result[1];
+		}
+
+		for (r=0; r < 2 && out[r]; r++)
+			pop += finish_row(body_old, out[r], BODY_ROW(body_old, y + r),
+					span->word_start, span->word_end, &diff);
+	}
+
+	*changed = diff != 0;
+	return pop;
+}
+
+/*
+ * Function:	naive_compute
+ * --------------------------
+ * The reference kernel, computes a span one cell at a time and maps every
+ * 	neighbor through the topology instead of reading the halo. It is slow
+ * 	and only meant to check the other kernels against.
+ *
+ * body_new: pointer to the body that will store the updated cells.
+ * body_old: pointer to the body that stores the previous generation of cells.
+ * span: the rows and words to compute.
+ * changed: set to 1 if any cell of the span changed, 0 otherwise.
+ *
+ * returns: the population of the span.
+ */
+static uint64_t naive_compute(body_t *body_new, const body_t *body_old, const span_t *span, int *changed)
+{
+	/* Neighbor n in N, NE, E, SE, S, SW, W, NW order, for isotropic rules */
+	static const int neighbor_dx[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+	static const int neighbor_dy[8] = { -1, -1, 0, 1, 1, 1, 0, -1 };
+	size_t y, i, x, p;
+	ptrdiff_t a, b, r = rule.radius;
+	int state, next, neighbors, n;
+	unsigned arrangement;
+	const uint64_t *row;
+	uint64_t *out, *decay, pop = 0, diff = 0;
+
+	for (y=span->row_start; y < span->row_end; y++) {
+		row = BODY_ROW(body_old, y);
+		out = BODY_ROW(body_new, y);
+
+		for (i=span->word_start; i < span->word_end; i++) {
+			out[i] = 0;
+			for (p=0; p < body_new->planes; p++)
+				BODY_PLANE_ROW(body_new, p, y)[i] = 0;
+
+			for (x=i * BODY_WORD_BITS; x < (i + 1) * BODY_WORD_BITS && x < body_old->cols; x++) {
+				state = body_state(body_old, x, y);
+				neighbors = rule.ltl && rule.middle ? 0 : -(state == 1);
+				for (b=-r; b <= r; b++)
+					for (a=-r; a <= r; a++)
+						neighbors += topology_get(body_old, (ptrdiff_t)x + a, (ptrdiff_t)y + b);
+
+				for (arrangement=0, n=0; rule.isotropic && n < 8; n++)
+					arrangement |= topology_get(body_old, (ptrdiff_t)x + neighbor_dx[n],
+							(ptrdiff_t)y + neighbor_dy[n]) << n;
+
+				if (rule.isotropic)
+					next = RULE_NEXT_CASE(rule, state, arrangement);
+				else if (rule.ltl)
+					next = state ? neighbors >= rule.survive_min && neighbors <= rule.survive_max :
+						neighbors >= rule.birth_min && neighbors <= rule.birth_max;
+				else if (state <= 1 && RULE_NEXT(rule, state, neighbors))
+					next = 1;
+				else if (state == 0)
+					next = 0;
+				else
+					next = (state + 1) % rule.states;
+
+				if (next == 1)
+					out[i] |= BODY_BIT(x);
+				for (p=0; next > 1 && p < body_new->planes; p++)
+					if ((next - 1) >> p & 1)
+						BODY_PLANE_ROW(body_new, p, y)[i] |= BODY_BIT(x);
+			}
+
+			for (p=0; p < body_new->planes; p++) {
+				decay = BODY_PLANE_ROW(body_new, p, y);
+				diff |= decay[i] ^ BODY_PLANE_ROW(body_old, p, y)[i];
+			}
+		}
+
+		pop += finish_row(body_old, out, row, span->word_start, span->word_end, &diff);
+	}
+
+	*changed = diff != 0;
+	return pop;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#define SIMD_NAME sse2_compute
+#define SIMD_TARGET "sse2,popcnt"
+#define SIMD_LANES 2
+#include "kernel_simd.h"
+#undef SIMD_NAME
+#undef SIMD_TARGET
+#undef SIMD_LANES
+
+#define SIMD_NAME avx2_compute
+#define SIMD_TARGET "avx2,popcnt"
+#define SIMD_LANES 4
+#include "kernel_simd.h"
+#undef SIMD_NAME
+#undef SIMD_TARGET
+#undef SIMD_LANES
+
+#define SIMD_NAME avx512_compute
+#define SIMD_TARGET "avx512f,popcnt"
+#define SIMD_LANES 8
+#include "kernel_simd.h"
+#undef SIMD_NAME
+#undef SIMD_TARGET
+#undef SIMD_LANES
+
+static int sse2_supported(void)
+{
+	return __builtin_cpu_supports("sse2") && __builtin_cpu_supports("popcnt");
+}
+
+static int avx2_supported(void)
+{
+	return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+}
+
+static int avx512_supported(void)
+{
+	return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("popcnt");
+}
+
+#endif
+
+/* Ordered from the most to the least preferred. */
+static const kernel_t kernels[] = {
+#if defined(__x86_64__) || defined(__i386__)
+	{ "avx512", avx512_supported, NULL, avx512_compute, RULE_FAMILY_CONWAY },
+	{ "avx2", avx2_supported, NULL, avx2_compute, RULE_FAMILY_CONWAY },
+	{ "sse2", sse2_supported, NULL, sse2_compute, RULE_FAMILY_CONWAY },
+#endif
+	{ "scalar", scalar_supported, NULL, scalar_compute, RULE_FAMILY_CONWAY },
+	{ "rule", scalar_supported, rule_init, rule_compute, RULE_FAMILY_CONWAY | RULE_FAMILY_TOTALISTIC },
+	{ "generations", scalar_supported, generations_init, generations_compute, RULE_FAMILY_GENERATIONS },
+	{ "lut", scalar_supported, lut_init, lut_compute, RULE_FAMILY_CONWAY | RULE_FAMILY_TOTALISTIC },
+	{ "colsum", scalar_supported, NULL, colsum_compute, RULE_FAMILY_CONWAY | RULE_FAMILY_TOTALISTIC },
+	{ "ltl", scalar_supported, NULL, ltl_compute, RULE_FAMILY_LTL },
+	{ "isotropic", scalar_supported, isotropic_init, isotropic_compute,
+		RULE_FAMILY_CONWAY | RULE_FAMILY_TOTALISTIC | RULE_FAMILY_ISOTROPIC },
+	{ "naive", scalar_supported, NULL, naive_compute, RULE_FAMILY_CONWAY | RULE_FAMILY_TOTALISTIC |
+		RULE_FAMILY_GENERATIONS | RULE_FAMILY_LTL | RULE_FAMILY_ISOTROPIC },
+	{ NULL, NULL, NULL, NULL, 0 }
+};
+
+/*
+ * Function:	kernel_find
+ * ------------------------
+ * Look up a kernel by name, "auto" selects the best supported kernel.
+ *
+ * name: the name of the kernel.
+ *
+ * returns: pointer to the kernel, NULL if it is unknown, not supported by this cpu,
+ * 	or cannot run the selected rule.
+ */
+const kernel_t *kernel_find(const char *name)
+{
+	const kernel_t *k;
+
+	if (!strcmp(name, "auto"))
+		return kernel_best();
+
+	for (k=kernels; k->name; k++) {
+		if (!strcmp(name, k->name)) {
+			if (!k->supported() || !(k->rules & rule_family(&rule)))
+				return NULL;
+			if (k->init)
+				k->init();
+			return k;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * Function:	kernel_best
+ * ------------------------
+ * Select the fastest kernel the cpu supports, checked with cpuid, that
+ * 	runs the selected rule.
+ *
+ * returns: pointer to the kernel.
+ */
+const kernel_t *kernel_best(void)
+{
+	const kernel_t *k;
+
+	__builtin_cpu_init();
+	for (k=kernels; k->name; k++) {
+		if (k->supported() && (k->rules & rule_family(&rule))) {
+			if (k->init)
+				k->init();
+			return k;
+		}
+	}
+
+	return NULL; /* Unreachable, the naive kernel runs every rule */
+}
+
+/*
+ * Function:	kernel_print_choices
+ * ---------------------------------
+ * Print the kernels, whether this cpu supports them, and whether they run
+ * 	the selected rule.
+ */
+void kernel_print_choices(void)
+{
+	const kernel_t *k;
+
+	__builtin_cpu_init();
+	fprintf(stderr, "Available Kernels:\n");
+	for (k=kernels; k->name; k++)
+		fprintf(stderr, "\t%s%s%s\n", k->name, k->supported() ? "" : " (not supported)",
+				k->rules & rule_family(&rule) ? "" : " (does not run the rule)");
+}
@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "pool.h"
+
+/*
+ * Function:	pool_init
+ * ----------------------
+ * Start a pool of worker threads. The calling thread takes part in every
+ * 	job as thread 0, so threads - 1 workers are created.
+ *
+ * threads: the number of threads running each job.
+ *
+ * returns: pointer to the newly allocated pool.
+ */
+pool_t *pool_init(size_t threads)
+{
+	size_t i;
+	struct pool_worker_arg *worker_arg;
+
+	pool_t *pool_new = malloc(sizeof(*pool_new));
+	if (!pool_new) {
+		perror("pool_init: Failed to malloc pool_new");
+		exit(EXIT_FAILURE);
+	}
+
+	pool_new->threads = threads;
+	pool_new->job = NULL;
+	pool_new->arg = NULL;
+	pool_new->quit = 0;
+
+	pool_new->slots = aligned_alloc(sizeof(*pool_new->slots), threads * sizeof(*pool_new->slots));
+	pool_new->workers = malloc(threads * sizeof(*pool_new->workers));
+	if (!pool_new->slots || !pool_new->workers) {
+		perror("pool_init: Failed to malloc pool_new->slots");
+		exit(EXIT_FAILURE);
+	}
+
+	pthread_barrier_init(&pool_new->start, NULL, threads);
+	pthread_barrier_init(&pool_new->done, NULL, threads);
+
+	for (i=1; i < threads; i++) {
+		worker_arg = malloc(sizeof(*worker_arg));
+		if (!worker_arg) {
+			perror("pool_init: Failed to malloc worker_arg");
+			exit(EXIT_FAILURE);
+		}
+		worker_arg->pool = pool_new;
+		worker_arg->id = i;
+
+		if (pthread_create(&pool_new->workers[i], NULL, pool_worker, worker_arg)) {
+			perror("pool_init: Failed to create worker thread");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	return pool_new;
+}
+
+/*
+ * Function:	pool_destroy
+ * -------------------------
+ * Stop the workers and destroy the pool.
+ *
+ * pool: pointer to the pool allocated in memory.
+ */
+void pool_destroy(pool_t *pool)
+{
+	size_t i;
+
+	pool->quit = 1;
+	if (pool->threads > 1)
+		pthread_barrier_wait(&pool->start);
+
+	for (i=1; i < pool->threads; i++)
+		pthread_join(pool->workers[i], NULL);
+
+	pthread_barrier_destroy(&pool->start);
+	pthread_barrier_destroy(&pool->done);
+	free(pool->workers);
+	free(pool->slots);
+	free(pool);
+}
+
+/*
+ * Function:	pool_worker
+ * ------------------------
+ * Worker thread loop, waits for a job, runs its share, and waits for the
+ * 	rest of the pool to finish.
+ *
+ * arg: the pool_worker_arg of this worker.
+ */
+static void *pool_worker(void *arg)
+{
+	struct pool_worker_arg *worker_arg = arg;
+	pool_t *pool = worker_arg->pool;
+	size_t id = worker_arg->id;
+
+	free(worker_arg);
+
+	for (;;) {
+		pthread_barrier_wait(&pool->start);
+		if (pool->quit)
+			break;
+
+		pool->slots[id].result = pool->job(pool->arg, id, pool->threads);
+		pthread_barrier_wait(&pool->done);
+	}
+
+	return NULL;
+}
+
+/*
+ * Function:	pool_run
+ * ---------------------
+ * Run a job on every thread of the pool and wait for all of them to finish.
+ * 	Each thread stores its result in its own slot, the slots are summed
+ * 	once the threads have passed the barrier.
+ *
+ * pool: the pool running the job, NULL runs the job on the calling thread.
+ * job: the function each thread runs.
+ * arg: the argument passed to the job.
+ *
+ * returns: the sum of the values returned by each thread.
+ */
+uint64_t pool_run(pool_t *pool, pool_job_t job, void *arg)
+{
+	size_t i;
+	uint64_t sum = 0;
+
+	if (!pool || pool->threads == 1)
+		return job(arg, 0, 1);
+
+	pool->job = job;
+	pool->arg = arg;
+	pthread_barrier_wait(&pool->start);
+
+	pool->slots[0].result = job(arg, 0, pool->threads);
+	pthread_barrier_wait(&pool->done);
+
+	for (i=0; i < pool->threads; i++)
+		sum += pool->slots[i].result;
+
+	return sum;
+}
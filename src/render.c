@@ -0,0 +1,617 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <SDL.h>
+#include <SDL_ttf.h>
+
+#include "render.h"
+#include "utilities.h"
+#include "cell.h"
+#include "engine.h"
+#include "rule.h"
+#include "simulation.h"
+
+/* Streaming texture holding one pixel per cell, see draw_generation */
+static SDL_Texture *cell_texture;
+static uint32_t *cell_pixels; /* the pixels of cell_texture, row-major */
+static body_t *cell_drawn; /* the cells cell_texture shows */
+
+/*
+ * Function:	draw_palette
+ * -------------------------
+ * Find the color of each state. Dying cells of a Generations rule fade
+ * 	from the cell color to the background color as they decay.
+ *
+ * palette: receives the ARGB8888 color of each of the rule's states.
+ */
+static void draw_palette(uint32_t *palette)
+{
+	int state, r, g, b;
+
+	for (state=0; state < rule.states; state++) {
+		if (state == 1) {
+			r = cell_meta.color_r;
+			g = cell_meta.color_g;
+			b = cell_meta.color_b;
+		} else if (state) {
+			r = cell_meta.color_r + (bg_meta.color_r - cell_meta.color_r) * (state - 1) / rule.states;
+			g = cell_meta.color_g + (bg_meta.color_g - cell_meta.color_g) * (state - 1) / rule.states;
+			b = cell_meta.color_b + (bg_meta.color_b - cell_meta.color_b) * (state - 1) / rule.states;
+		} else {
+			r = bg_meta.color_r;
+			g = bg_meta.color_g;
+			b = bg_meta.color_b;
+		}
+		palette[state] = (uint32_t)SDL_ALPHA_OPAQUE << 24 | (uint32_t)r << 16 | (uint32_t)g << 8 | (uint32_t)b;
+	}
+}
+
+/*
+ * Function:	draw_grid
+ * ----------------------
+ * Draw the outline of every cell, a line along either side of each row
+ * 	and column of cells.
+ *
+ * renderer: SDL_Renderer struct used for rendering the grid.
+ * body: the body the grid is drawn over.
+ */
+static void draw_grid(SDL_Renderer *renderer, const body_t *body)
+{
+	int x, y;
+	int w = cell_meta.width * body->cols, h = cell_meta.height * body->rows;
+
+	SDL_SetRenderDrawColor(renderer, 215, 215, 215, SDL_ALPHA_OPAQUE);
+	for (x=0; x < w; x += cell_meta.width) {
+		SDL_RenderDrawLine(renderer, x, 0, x, h - 1);
+		SDL_RenderDrawLine(renderer, x + cell_meta.width - 1, 0, x + cell_meta.width - 1, h - 1);
+	}
+	for (y=0; y < h; y += cell_meta.height) {
+		SDL_RenderDrawLine(renderer, 0, y, w - 1, y);
+		SDL_RenderDrawLine(renderer, 0, y + cell_meta.height - 1, w - 1, y + cell_meta.height - 1);
+	}
+	SDL_SetRenderDrawColor(renderer, bg_meta.color_r, bg_meta.color_g, bg_meta.color_b, SDL_ALPHA_OPAQUE);
+}
+
+/*
+ * Function:	draw_block
+ * -----------------------
+ * Repaint a block of cells, one word wide, in cell_pixels if it differs
+ * 	from the cells the texture shows.
+ *
+ * body: the body containing the current generation of cells.
+ * palette: the color of each state, see draw_palette.
+ * y_start: the first row of the block.
+ * y_end: the row after the last row of the block.
+ * word: the word of the rows holding the block.
+ * full: 1 if the block is repainted even when it is the same.
+ *
+ * returns: 1 if the block was repainted, 0 otherwise.
+ */
+static int draw_block(const body_t *body, const uint32_t *palette, size_t y_start, size_t y_end,
+		size_t word, int full)
+{
+	size_t x, y, p;
+	size_t x_end = (word + 1) * BODY_WORD_BITS < body->cols ? (word + 1) * BODY_WORD_BITS : body->cols;
+	uint32_t *out;
+	int same = !full;
+
+	for (y=y_start; same && y < y_end; y++)
+		for (p=0; p <= body->planes; p++)
+			same &= (BODY_ROW(body, y) + p * body->plane_size)[word] ==
+				(BODY_ROW(cell_drawn, y) + p * cell_drawn->plane_size)[word];
+	if (same)
+		return 0;
+
+	for (y=y_start; y < y_end; y++) {
+		out = cell_pixels + y * body->cols;
+		for (x=word * BODY_WORD_BITS; x < x_end; x++)
+			out[x] = palette[body->planes ? body_state(body, x, y) : (int)BODY_ROW_GET(BODY_ROW(body, y), x)];
+		for (p=0; p <= body->planes; p++)
+			(BODY_ROW(cell_drawn, y) + p * cell_drawn->plane_size)[word] =
+				(BODY_ROW(body, y) + p * body->plane_size)[word];
+	}
+
+	return 1;
+}
+
+/*
+ * Function:	draw_generation
+ * ----------------------------
+ * Draw the current generation's cells. Each cell is one pixel of a
+ * 	streaming texture stretched to the cell size without filtering, so a
+ * 	frame costs the same whatever the size of the cells. The texture is
+ * 	kept from frame to frame and only the tiles the body marks changed
+ * 	are visited, see reference_read. Their blocks of cells that differ
+ * 	from the texture are repainted and uploaded, a run of changed blocks
+ * 	at a time, so the cost follows the changed cells, not the body size.
+ *
+ * renderer: SDL_Renderer struct used for rendering the cells.
+ * body: the body containing the current generation of cells.
+ */
+void draw_generation(SDL_Renderer *renderer, body_t *body)
+{
+	size_t r, c, i, y, y_end, y_tile_end, word_end, run;
+	int full = 0;
+	uint32_t palette[RULE_STATES_MAX];
+	SDL_Rect rect;
+
+	if (!cell_drawn || cell_drawn->cols != body->cols || cell_drawn->rows != body->rows) {
+		draw_destroy();
+		SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "nearest");
+		cell_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+				body->cols, body->rows);
+		if (!cell_texture) {
+			perror("draw_generation: SDL_CreateTexture failed");
+			exit(EXIT_FAILURE);
+		}
+
+		cell_pixels = malloc(body->rows * body->cols * sizeof(*cell_pixels));
+		if (!cell_pixels) {
+			perror("draw_generation: Failed to malloc cell_pixels");
+			exit(EXIT_FAILURE);
+		}
+		cell_drawn = body_init(body->rows, body->cols);
+		full = 1;
+	}
+
+	draw_palette(palette);
+	for (r=0; r < body->tile_rows; r++) {
+		y_tile_end = (r + 1) * body->tile_height < body->rows ? (r + 1) * body->tile_height : body->rows;
+		for (c=0; c < body->tile_cols; c++) {
+			if (!full && !body->tiles[r * body->tile_cols + c].changed)
+				continue;
+
+			word_end = (c + 1) * body->tile_words < body->words ? (c + 1) * body->tile_words : body->words;
+			for (y=r * body->tile_height; y < y_tile_end; y += DRAW_BLOCK_ROWS) {
+				y_end = y + DRAW_BLOCK_ROWS < y_tile_end ? y + DRAW_BLOCK_ROWS : y_tile_end;
+				for (i=c * body->tile_words; i < word_end; i++) {
+					if (!draw_block(body, palette, y, y_end, i, full))
+						continue;
+
+					for (run=i + 1; run < word_end && draw_block(body, palette, y, y_end, run, full); run++)
+						;
+					rect.x = i * BODY_WORD_BITS;
+					rect.y = y;
+					rect.w = (run * BODY_WORD_BITS < body->cols ? run * BODY_WORD_BITS : body->cols) - rect.x;
+					rect.h = y_end - y;
+					if (SDL_UpdateTexture(cell_texture, &rect, cell_pixels + y * body->cols + rect.x,
+							body->cols * sizeof(*cell_pixels))) {
+						perror("draw_generation: SDL_UpdateTexture failed");
+						exit(EXIT_FAILURE);
+					}
+					i = run;
+				}
+			}
+		}
+	}
+
+	rect.x = 0;
+	rect.y = 0;
+	rect.w = cell_meta.width * body->cols;
+	rect.h = cell_meta.height * body->rows;
+	if (SDL_RenderCopy(renderer, cell_texture, NULL, &rect) == -1) {
+		perror("draw_generation: SDL_RenderCopy failed");
+		exit(EXIT_FAILURE);
+	}
+
+	if (cell_meta.grid_on)
+		draw_grid(renderer, body);
+}
+
+/*
+ * Function:	draw_destroy
+ * -------------------------
+ * Destroy the texture the cells are drawn in, before its renderer is.
+ */
+void draw_destroy(void)
+{
+	if (cell_texture)
+		SDL_DestroyTexture(cell_texture);
+	if (cell_drawn)
+		body_destory(cell_drawn);
+	free(cell_pixels);
+	cell_texture = NULL;
+	cell_drawn = NULL;
+	cell_pixels = NULL;
+}
+/*
+ * Function:	drawing_mode
+ * ------------------------
+ * A mode of cell generation, user selects the cells to be alive and then starts simulation.
+ *
+ * renderer: SDL_Renderer used for rendering the window.
+ * body: pointer to the body that will store the updated cells.
+ * pop: pointer to the population count used for tracking the body's progress.
+ *
+ * returns: pointer to body with its initial conditions set.
+ */
+body_t *drawing_mode(SDL_Renderer *renderer, body_t *body, uint64_t *pop)
+{
+	int capturing_input, x, y;
+	SDL_Event event;
+	SDL_Color color = {0, 0, 0}; /* black */
+	char text[] = "DRAWING MODE";
+	int temp = cell_meta.grid_on;
+
+	cell_meta.grid_on = 1;
+
+	SDL_RenderClear(renderer);
+	draw_generation(renderer, body);
+	display_body_statistics(renderer, 0, *pop);
+	display_text(renderer, text, color, 24, 25, 100, 0, 0);
+	SDL_RenderPresent(renderer);
+
+	capturing_input = 1;
+	while(capturing_input) {
+		/* Poll for events */
+		while (SDL_PollEvent(&event))
+			switch (event.type) {
+				case SDL_QUIT:
+					return NULL;
+				case SDL_KEYDOWN:
+					switch (event.key.keysym.sym) {
+						case SDLK_SPACE:
+							capturing_input = 0;
+							break;
+						case SDLK_q:
+							return NULL;
+					}
+					break;
+				case SDL_MOUSEBUTTONDOWN:
+					if (event.button.button == SDL_BUTTON_LEFT) {
+						SDL_GetMouseState(&x, &y);
+						x /= cell_meta.width;
+						y /= cell_meta.height;
+
+						BODY_TOGGLE(body, x, y);
+						if (BODY_GET(body, x, y))
+							*pop += 1;
+						else
+							*pop -= 1;
+
+						SDL_RenderClear(renderer);
+						draw_generation(renderer, body);
+						display_body_statistics(renderer, 0, *pop);
+						display_text(renderer, text, color, 24, 25, 100, 0, 0);
+						SDL_RenderPresent(renderer);
+					}
+					break;
+			}
+	}
+
+	cell_meta.grid_on = temp;
+	return body;
+}
+/* Glyph atlas of each font size in use, see text_atlas */
+static struct glyph_atlas text_atlases[TEXT_ATLAS_MAX];
+
+/*
+ * Function:	text_font
+ * ----------------------
+ * Open the font the text is drawn in.
+ *
+ * font_size: the point size of the font.
+ *
+ * returns: the opened font.
+ */
+static TTF_Font *text_font(int font_size)
+{
+	TTF_Font* font;
+	char *font_path;
+	char font_rel_path[] = "/data/assets/Arial.ttf";
+
+	font_path = malloc(strlen(proj_dir) + strlen(font_rel_path) + 1);
+	if (!font_path) {
+		perror("text_font: Failed to malloc font_path");
+		exit(EXIT_FAILURE);
+	}
+	strcpy(font_path, proj_dir);
+	strcat(font_path, font_rel_path);
+
+	font = TTF_OpenFont(font_path, font_size);
+	if (!font) {
+		printf("%s\n", TTF_GetError());
+		perror("text_font: TTF_OpenFont failed");
+		exit(EXIT_FAILURE);
+	}
+	free(font_path);
+
+	return font;
+}
+
+/*
+ * Function:	text_atlas
+ * -----------------------
+ * Find the glyph atlas of a font size, building it the first time. The
+ * 	font is opened once and every printable character rendered side by
+ * 	side in white into a single texture, tinted to the text color when
+ * 	it is drawn.
+ *
+ * renderer: SDL_Renderer the atlas texture is created for.
+ * font_size: the point size of the font.
+ *
+ * returns: pointer to the glyph atlas.
+ */
+static struct glyph_atlas *text_atlas(SDL_Renderer *renderer, int font_size)
+{
+	TTF_Font* font;
+	SDL_Surface *surface_atlas, *surface_glyph;
+	SDL_Color white = {255, 255, 255, SDL_ALPHA_OPAQUE};
+	SDL_Rect glyph_rect;
+	struct glyph_atlas *atlas;
+	char glyph[2] = { 0 };
+	int i, width = 0;
+
+	for (i=0; i < TEXT_ATLAS_MAX && text_atlases[i].texture; i++)
+		if (text_atlases[i].font_size == font_size)
+			return &text_atlases[i];
+	if (i == TEXT_ATLAS_MAX) {
+		fprintf(stderr, "text_atlas: More than %d font sizes\n", TEXT_ATLAS_MAX);
+		exit(EXIT_FAILURE);
+	}
+	atlas = &text_atlases[i];
+	atlas->font_size = font_size;
+
+	font = text_font(font_size);
+	for (i=0; i < GLYPH_COUNT; i++) {
+		glyph[0] = GLYPH_FIRST + i;
+		if (TTF_SizeText(font, glyph, &atlas->glyphs[i].w, &atlas->glyphs[i].h)) {
+			perror("text_atlas: TTF_SizeText failed");
+			exit(EXIT_FAILURE);
+		}
+		atlas->glyphs[i].x = width;
+		atlas->glyphs[i].y = 0;
+		width += atlas->glyphs[i].w;
+	}
+
+	surface_atlas = SDL_CreateRGBSurfaceWithFormat(0, width, TTF_FontHeight(font), 32, SDL_PIXELFORMAT_RGBA32);
+	if (!surface_atlas) {
+		perror("text_atlas: SDL_CreateRGBSurfaceWithFormat failed");
+		exit(EXIT_FAILURE);
+	}
+
+	for (i=0; i < GLYPH_COUNT; i++) {
+		glyph[0] = GLYPH_FIRST + i;
+		surface_glyph = TTF_RenderText_Solid(font, glyph, white);
+		if (!surface_glyph) {
+			perror("text_atlas: TTF_RenderText_Solid failed");
+			exit(EXIT_FAILURE);
+		}
+		glyph_rect = atlas->glyphs[i]; /* the blit clips the rect it is given */
+		SDL_BlitSurface(surface_glyph, NULL, surface_atlas, &glyph_rect);
+		SDL_FreeSurface(surface_glyph);
+	}
+
+	atlas->texture = SDL_CreateTextureFromSurface(renderer, surface_atlas);
+	if (!atlas->texture) {
+		perror("text_atlas: SDL_CreateTextureFromSurface failed");
+		exit(EXIT_FAILURE);
+	}
+	SDL_SetTextureBlendMode(atlas->texture, SDL_BLENDMODE_BLEND);
+
+	TTF_CloseFont(font);
+	SDL_FreeSurface(surface_atlas);
+
+	return atlas;
+}
+
+/*
+ * Function:	text_init
+ * ----------------------
+ * Build the glyph atlas of the statistics at startup.
+ *
+ * renderer: SDL_Renderer used for rendering the text.
+ */
+void text_init(SDL_Renderer *renderer)
+{
+	text_atlas(renderer, STAT_FONT_SIZE);
+}
+
+/*
+ * Function:	text_destroy
+ * -------------------------
+ * Destroy the glyph atlases, before their renderer is.
+ */
+void text_destroy(void)
+{
+	int i;
+
+	for (i=0; i < TEXT_ATLAS_MAX; i++) {
+		if (text_atlases[i].texture)
+			SDL_DestroyTexture(text_atlases[i].texture);
+		text_atlases[i].texture = NULL;
+	}
+}
+
+/*
+ * Function:	display_text
+ * -------------------------
+ * Display text on the window, one copy from the glyph atlas per character.
+ * 	Characters that are not printable are drawn as '?'.
+ *
+ * renderer: SDL_Renderer used for rendering the text.
+ * color: the color for rendering the text.
+ * x: the column to start rendering the text.
+ * y: the row to start rendering the text.
+ * w: the width of the text box, unused, the text is drawn at its size.
+ * h: the height of the text box, unused.
+ */
+void display_text(SDL_Renderer *renderer, char *text, SDL_Color color, int font_size, int x, int y, int w, int h)
+{
+	struct glyph_atlas *atlas = text_atlas(renderer, font_size);
+	SDL_Rect message_rect, *glyph;
+	int c;
+
+	(void)w;
+	(void)h;
+	SDL_SetTextureColorMod(atlas->texture, color.r, color.g, color.b);
+
+	message_rect.x = x;
+	message_rect.y = y;
+	for (; *text; text++) {
+		c = *text >= GLYPH_FIRST && *text <= GLYPH_LAST ? *text : '?';
+		glyph = &atlas->glyphs[c - GLYPH_FIRST];
+		message_rect.w = glyph->w;
+		message_rect.h = glyph->h;
+
+		if (SDL_RenderCopy(renderer, atlas->texture, glyph, &message_rect) == -1) {
+			perror("display_text: SDL_RenderCopy failed to display the message");
+			exit(EXIT_FAILURE);
+		}
+		message_rect.x += glyph->w;
+	}
+}
+/*
+ * Function:	display_body_statistics
+ * ------------------------------------
+ * Display the current generation and population.
+ *
+ * renderer: SDL_Renderer used for rendering the statistics.
+ * gen: the current generation count.
+ * pop: the current population count.
+ */
+void display_body_statistics(SDL_Renderer *renderer, uint64_t gen, uint64_t pop)
+{
+	char text[124];
+	SDL_Color color;
+
+	if (cell_meta.grid_on)
+		color.r = color.g = color.b = 0; /* Black */
+	else
+		color.r = color.g = color.b = 101; /* Light Gray */
+
+	sprintf(text, "Current Generation: %" PRIu64, gen);
+	DISPLAY_STAT(renderer, text, color, 25);
+
+	sprintf(text, "Population: %" PRIu64, pop);
+	DISPLAY_STAT(renderer, text, color, 50);
+}
+
+/*
+ * Function:	run_window
+ * -----------------------
+ * Open the window, populate the initial body, and show the simulation
+ * 	running on its own thread until the window is closed.
+ */
+void run_window(void)
+{
+	uint32_t delay_interval;
+	int done;
+	unsigned step_log;
+	uint64_t population = 0;
+	body_t *body;
+	void *state = NULL;
+	simulation_t *sim = NULL;
+	frame_t *frame = NULL;
+	SDL_Window* window;
+	SDL_Renderer *renderer;
+	SDL_Event event;
+
+	if (TTF_Init()) /* Initialize TTF */
+		exit(EXIT_FAILURE);
+
+	if (SDL_Init(SDL_INIT_VIDEO)) /* Initialize window */
+		exit(EXIT_FAILURE);
+
+	window = SDL_CreateWindow("Conway's Game of Life - Jack McVeigh", SDL_WINDOWPOS_UNDEFINED,
+			SDL_WINDOWPOS_UNDEFINED, bg_meta.width, bg_meta.height, SDL_WINDOW_OPENGL);
+	if (!window) {
+		perror("run_window: Failed to create window");
+		goto destrory_window_exit;
+	}
+
+	renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+	if (!renderer) {
+		perror("run_window: Failed to create renderer");
+		goto destrory_renderer_exit;
+	}
+	SDL_SetRenderDrawColor(renderer, bg_meta.color_r, bg_meta.color_g, bg_meta.color_b, SDL_ALPHA_OPAQUE); /* salmon-ish */
+	text_init(renderer);
+
+	/* Initialize the engine and the body shown in the window */
+	body = body_init(cell_meta.rows, cell_meta.cols);
+	state = engine->init(cell_meta.rows, cell_meta.cols);
+	if (mode == 'd') {
+		if (!drawing_mode(renderer, body, &population))
+			goto destroy_all_and_exit;
+		engine->load(state, body);
+	} else {
+		if (!inital_generation(state, &population))
+			goto destroy_all_and_exit;
+		engine->read(state, body);
+	}
+
+	/* Main loop, the simulation steps on its own thread and the window shows its newest generation */
+	done = step_log = 0;
+	delay_interval = DELAY_DEFAULT;
+	sim = simulation_start(state, body, population, delay_interval);
+	while (!done) {
+		/* Render */
+		if (triple_front(&sim->triple) != frame) {
+			frame = triple_front(&sim->triple);
+			SDL_RenderClear(renderer);
+			draw_generation(renderer, frame->body);
+			display_body_statistics(renderer, frame->generation, frame->population);
+			SDL_RenderPresent(renderer);
+		} else {
+			SDL_Delay(RENDER_DELAY);
+		}
+
+		/* Poll for events */
+		while (SDL_PollEvent(&event))
+			switch (event.type) {
+				case SDL_QUIT:
+					done = 1;
+					break;
+				case SDL_KEYDOWN:
+					switch (event.key.keysym.sym) {
+						case SDLK_SPACE:
+							__atomic_xor_fetch(&sim->pause, 1, __ATOMIC_ACQ_REL);
+							break;
+						case SDLK_UP:
+							if (delay_interval >= 100)
+								delay_interval -= 100;
+							__atomic_store_n(&sim->delay, delay_interval, __ATOMIC_RELAXED);
+							break;
+						case SDLK_DOWN:
+							if (delay_interval < (DELAY_DEFAULT * 4))
+								delay_interval += 100;
+							__atomic_store_n(&sim->delay, delay_interval, __ATOMIC_RELAXED);
+							break;
+						case SDLK_RIGHT: /* Double the step size */
+							if (step_log < engine->step_log_max)
+								step_log++;
+							__atomic_store_n(&sim->step_log, step_log, __ATOMIC_RELAXED);
+							break;
+						case SDLK_LEFT: /* Halve the step size */
+							if (step_log > 0)
+								step_log--;
+							__atomic_store_n(&sim->step_log, step_log, __ATOMIC_RELAXED);
+							break;
+						case SDLK_q:
+							done = 1;
+							break;
+						case SDLK_e:
+							export_body(frame->body, frame->generation);
+							break;
+					}
+					break;
+			}
+	}
+	simulation_stop(sim);
+
+	/* Destory program */
+destroy_all_and_exit:
+	body_destory(body);
+	if (state)
+		engine->destroy(state);
+	draw_destroy();
+	text_destroy();
+destrory_renderer_exit:
+	SDL_DestroyRenderer(renderer);
+destrory_window_exit:
+	SDL_DestroyWindow(window);
+	SDL_Quit();
+	TTF_Quit();
+}
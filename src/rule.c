@@ -0,0 +1,353 @@
+#include <stdlib.h>
+#include <ctype.h>
+#include <string.h>
+
+#include "rule.h"
+
+/*
+ * The Hensel letters of 1 to 4 neighbors and one arrangement of each, bit i
+ * 	is neighbor i in N, NE, E, SE, S, SW, W, NW order. The letters of 5 to
+ * 	7 neighbors are the complements of the letters of 3 to 1 neighbors.
+ */
+static const struct hensel_letter {
+	uint8_t count;
+	char letter;
+	uint8_t neighbors;
+} hensel_letters[] = {
+	{ 1, 'c', 0x02 }, { 1, 'e', 0x01 },
+	{ 2, 'c', 0x0A }, { 2, 'e', 0x05 }, { 2, 'k', 0x09 }, { 2, 'a', 0x03 }, { 2, 'i', 0x11 },
+	{ 2, 'n', 0x22 },
+	{ 3, 'c', 0x2A }, { 3, 'e', 0x15 }, { 3, 'k', 0x25 }, { 3, 'a', 0x07 }, { 3, 'i', 0x83 },
+	{ 3, 'n', 0x0B }, { 3, 'y', 0x29 }, { 3, 'q', 0x23 }, { 3, 'j', 0x43 }, { 3, 'r', 0x13 },
+	{ 4, 'c', 0xAA }, { 4, 'e', 0x55 }, { 4, 'k', 0x4B }, { 4, 'a', 0x0F }, { 4, 'i', 0x1B },
+	{ 4, 'n', 0x8B }, { 4, 'y', 0x2B }, { 4, 'q', 0x27 }, { 4, 'j', 0x53 }, { 4, 'r', 0x17 },
+	{ 4, 't', 0x39 }, { 4, 'w', 0x36 }, { 4, 'z', 0x33 },
+	{ 0, 0, 0 }
+};
+
+/*
+ * Function:	rule_count_cases
+ * -----------------------------
+ * Add every arrangement of a number of neighbors to a set of cases.
+ *
+ * count: the number of alive neighbors.
+ * cases: the set the arrangements are added to.
+ */
+static void rule_count_cases(int count, uint64_t cases[RULE_CASES / 64])
+{
+	int n;
+
+	for (n=0; n < RULE_CASES; n++)
+		if (__builtin_popcount(n) == count)
+			cases[n / 64] |= (uint64_t)1 << (n % 64);
+}
+
+/*
+ * Function:	rule_letter_cases
+ * ------------------------------
+ * Add the arrangements of a Hensel letter to a set of cases, the eight
+ * 	rotations and reflections of the arrangement in hensel_letters.
+ *
+ * count: the number of alive neighbors.
+ * letter: the letter.
+ * cases: the set the arrangements are added to.
+ *
+ * returns: 0 on success, -1 if the letter does not exist for the count.
+ */
+static int rule_letter_cases(int count, char letter, uint64_t cases[RULE_CASES / 64])
+{
+	const struct hensel_letter *h;
+	unsigned n, r, i, mirror;
+
+	for (h=hensel_letters; h->count; h++)
+		if (h->letter == letter && (h->count == count || h->count == 8 - count))
+			break;
+	if (!h->count)
+		return -1;
+
+	n = h->count == count ? h->neighbors : (uint8_t)~h->neighbors;
+	for (r=0; r < 4; r++) {
+		n = ((n << 2) | (n >> 6)) & 0xFF; /* a quarter turn */
+		for (mirror=0, i=0; i < 8; i++) /* flipped left to right, neighbor i to 8 - i */
+			mirror |= (n >> i & 1) << ((8 - i) % 8);
+		cases[n / 64] |= (uint64_t)1 << (n % 64);
+		cases[mirror / 64] |= (uint64_t)1 << (mirror % 64);
+	}
+
+	return 0;
+}
+
+/*
+ * Function:	rule_cases_totalistic
+ * ----------------------------------
+ * Check whether a set of cases only depends on the number of neighbors.
+ *
+ * cases: the set of cases.
+ *
+ * returns: 1 if every number of neighbors has all or none of its cases, 0 otherwise.
+ */
+static int rule_cases_totalistic(const uint64_t cases[RULE_CASES / 64])
+{
+	uint64_t all[RULE_CASES / 64];
+	int count, i, some, every;
+
+	for (count=0; count <= 8; count++) {
+		memset(all, 0, sizeof(all));
+		rule_count_cases(count, all);
+		some = 0;
+		every = 1;
+		for (i=0; i < RULE_CASES / 64; i++) {
+			some |= (cases[i] & all[i]) != 0;
+			every &= (cases[i] & all[i]) == all[i];
+		}
+		if (some && !every)
+			return 0;
+	}
+
+	return 1;
+}
+
+/*
+ * Function:	rule_parse_counts
+ * ------------------------------
+ * Parse the neighbor counts of one half of a rule string. A count may be
+ * 	followed by Hensel letters to only keep those arrangements of its
+ * 	neighbors, or by a '-' and letters to leave them out.
+ *
+ * str: the counts, ending at a '/' or the end of the string.
+ * counts: set to the mask of the counts.
+ * cases: set to the arrangements of the neighbors.
+ *
+ * returns: the number of characters parsed, -1 if a count is not 0-8 or a
+ * 	letter does not exist for its count.
+ */
+static int rule_parse_counts(const char *str, uint16_t *counts, uint64_t cases[RULE_CASES / 64])
+{
+	uint64_t letters[RULE_CASES / 64], all[RULE_CASES / 64];
+	int i, j, count, negate;
+
+	*counts = 0;
+	memset(cases, 0, RULE_CASES / 8);
+	for (i=0; str[i] && str[i] != '/';) {
+		if (str[i] < '0' || str[i] > '8')
+			return -1;
+		count = str[i++] - '0';
+		*counts |= RULE_N(count);
+
+		memset(all, 0, sizeof(all));
+		rule_count_cases(count, all);
+		negate = str[i] == '-';
+		i += negate;
+		memset(letters, 0, sizeof(letters));
+		for (; islower(str[i]); i++)
+			if (rule_letter_cases(count, str[i], letters))
+				return -1;
+		if (negate && letters[0] == 0 && letters[1] == 0 && letters[2] == 0 && letters[3] == 0)
+			return -1;
+
+		for (j=0; j < RULE_CASES / 64; j++) {
+			if (negate)
+				cases[j] |= all[j] & ~letters[j];
+			else if (islower(str[i - 1]))
+				cases[j] |= letters[j];
+			else
+				cases[j] |= all[j];
+		}
+	}
+
+	return i;
+}
+
+/*
+ * Function:	rule_parse_ltl
+ * ---------------------------
+ * Parse a Larger than Life rule such as "R5,C0,M1,S34..58,B34..45,NM".
+ * 	Only two states (C0 or C2) and the square neighborhood (NM) are
+ * 	supported, C and N may be left out, M defaults to 0.
+ *
+ * str: the rule string.
+ * rule: set to the parsed rule.
+ *
+ * returns: 0 on success, -1 if the string is not a supported rule.
+ */
+static int rule_parse_ltl(const char *str, rule_t *rule)
+{
+	long value, max;
+	char *end;
+	char field;
+	int seen = 0;
+
+	rule->ltl = 1;
+	rule->middle = 0;
+	rule->states = 2;
+	rule->birth = rule->survive = 0;
+
+	while (*str) {
+		field = toupper(*str++);
+		if (field == 'N') {
+			if (toupper(*str++) != 'M')
+				return -1;
+			end = (char *)str;
+		} else {
+			value = strtol(str, &end, 10);
+			if (end == str || value < 0)
+				return -1;
+		}
+
+		switch (field) {
+			case 'R':
+				if (value < 1 || value > RULE_RADIUS_MAX)
+					return -1;
+				rule->radius = value;
+				seen |= 1;
+				break;
+			case 'C':
+				if (value != 0 && value != 2)
+					return -1;
+				break;
+			case 'M':
+				if (value > 1)
+					return -1;
+				rule->middle = value;
+				break;
+			case 'S':
+			case 'B':
+				if (end[0] != '.' || end[1] != '.')
+					return -1;
+				str = end + 2;
+				max = strtol(str, &end, 10);
+				if (end == str || max < value)
+					return -1;
+				if (field == 'S') {
+					rule->survive_min = value;
+					rule->survive_max = max;
+					seen |= 2;
+				} else {
+					rule->birth_min = value;
+					rule->birth_max = max;
+					seen |= 4;
+				}
+				break;
+			case 'N':
+				break;
+			default:
+				return -1;
+		}
+
+		str = end;
+		if (*str == ',')
+			str++;
+		else if (*str)
+			return -1;
+	}
+
+	return seen == 7 ? 0 : -1;
+}
+
+/*
+ * Function:	rule_parse
+ * -----------------------
+ * Parse a rule string, either B/S notation such as "B36/S23" in any order
+ * 	and case, or the older S/B notation such as "23/36". Generations
+ * 	rules add the number of states, "B2/S/C3" or "/2/3". The counts may
+ * 	carry Hensel letters, "B2-a/S12", for isotropic non-totalistic
+ * 	rules. Larger than Life rules start with their radius, see
+ * 	rule_parse_ltl.
+ *
+ * str: the rule string.
+ * rule: set to the parsed rule.
+ *
+ * returns: 0 on success, -1 if the string is not a rule.
+ */
+int rule_parse(const char *str, rule_t *rule)
+{
+	int len, half;
+	long states;
+	char *end;
+	uint16_t *counts[2] = { &rule->survive, &rule->birth }; /* S/B order */
+	int seen[2] = { 0, 0 };
+
+	rule->ltl = 0;
+	rule->isotropic = 0;
+	rule->radius = 1;
+	if (toupper(str[0]) == 'R' && isdigit(str[1]))
+		return rule_parse_ltl(str, rule);
+
+	for (half=0; half < 2; half++) {
+		if (toupper(*str) == 'B' || toupper(*str) == 'S') {
+			counts[half] = toupper(*str) == 'B' ? &rule->birth : &rule->survive;
+			str++;
+		}
+		if (seen[counts[half] == &rule->birth])
+			return -1;
+		seen[counts[half] == &rule->birth] = 1;
+
+		if ((len = rule_parse_counts(str, counts[half], counts[half] == &rule->birth ?
+				rule->birth_cases : rule->survive_cases)) < 0)
+			return -1;
+		str += len;
+
+		if (half == 0 && *str++ != '/')
+			return -1;
+	}
+
+	rule->states = 2;
+	if (*str == '/') {
+		str++;
+		if (toupper(*str) == 'C')
+			str++;
+		states = strtol(str, &end, 10);
+		if (end == str || states < 2 || states > RULE_STATES_MAX)
+			return -1;
+		rule->states = states;
+		str = end;
+	}
+
+	rule->isotropic = !rule_cases_totalistic(rule->birth_cases) || !rule_cases_totalistic(rule->survive_cases);
+	if (rule->isotropic && rule->states > 2)
+		return -1;
+
+	return *str ? -1 : 0;
+}
+
+/*
+ * Function:	rule_family
+ * ------------------------
+ * Get the family of a rule.
+ *
+ * rule: the rule.
+ *
+ * returns: the RULE_FAMILY_* of the rule.
+ */
+unsigned rule_family(const rule_t *rule)
+{
+	if (rule->ltl)
+		return RULE_FAMILY_LTL;
+	if (rule->isotropic)
+		return RULE_FAMILY_ISOTROPIC;
+	if (rule->states > 2)
+		return RULE_FAMILY_GENERATIONS;
+	if (RULE_IS_CONWAY(*rule))
+		return RULE_FAMILY_CONWAY;
+	return RULE_FAMILY_TOTALISTIC;
+}
+
+/*
+ * Function:	rule_planes
+ * ------------------------
+ * Get the number of bit planes holding the decay of a Generations rule,
+ * 	dying states 2 to states - 1 are stored as 1 to states - 2.
+ *
+ * rule: the rule.
+ *
+ * returns: the number of decay planes, 0 for two-state rules.
+ */
+size_t rule_planes(const rule_t *rule)
+{
+	size_t planes = 0;
+
+	while (((size_t)1 << planes) <= (size_t)rule->states - 2)
+		planes++;
+
+	return planes;
+}
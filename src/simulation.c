@@ -0,0 +1,246 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "simulation.h"
+#include "cell.h"
+#include "engine.h"
+#include "utilities.h"
+
+/*
+ * Function:	triple_init
+ * ------------------------
+ * Allocate the frames of a triple buffer, each holding the initial
+ * 	generation so the window has a frame to show from the start.
+ *
+ * triple: the triple buffer.
+ * body: the body holding the initial generation.
+ * population: the population of the initial generation.
+ */
+void triple_init(triple_t *triple, const body_t *body, uint64_t population)
+{
+	size_t i;
+
+	for (i=0; i < TRIPLE_FRAMES; i++) {
+		triple->frames[i].body = body_init(body->rows, body->cols);
+		body_copy(triple->frames[i].body, body);
+		triple->frames[i].generation = 0;
+		triple->frames[i].population = population;
+	}
+
+	triple->back = 0;
+	triple->middle = 1;
+	triple->front = 2;
+}
+
+/*
+ * Function:	triple_destroy
+ * ---------------------------
+ * Free the frames of a triple buffer.
+ *
+ * triple: the triple buffer.
+ */
+void triple_destroy(triple_t *triple)
+{
+	size_t i;
+
+	for (i=0; i < TRIPLE_FRAMES; i++)
+		body_destory(triple->frames[i].body);
+}
+
+/*
+ * Function:	triple_publish
+ * ---------------------------
+ * Hand the filled back frame to the window, taking the middle frame as
+ * 	the next back frame. A middle frame the window has not taken is
+ * 	dropped, it is older than the one published.
+ *
+ * triple: the triple buffer.
+ *
+ * returns: 1 if the window took the previously published frame, 0 if it was dropped.
+ */
+int triple_publish(triple_t *triple)
+{
+	unsigned middle = __atomic_exchange_n(&triple->middle, triple->back | TRIPLE_FRESH, __ATOMIC_ACQ_REL);
+
+	triple->back = middle & TRIPLE_INDEX;
+	return !(middle & TRIPLE_FRESH);
+}
+
+/*
+ * Function:	triple_front
+ * -------------------------
+ * Get the newest published frame. The front frame is swapped with the
+ * 	middle frame when a newer one was published, otherwise it is kept.
+ * 	The frame stays the window's until the next call.
+ *
+ * triple: the triple buffer.
+ *
+ * returns: pointer to the front frame.
+ */
+frame_t *triple_front(triple_t *triple)
+{
+	if (__atomic_load_n(&triple->middle, __ATOMIC_ACQUIRE) & TRIPLE_FRESH)
+		triple->front = __atomic_exchange_n(&triple->middle, triple->front, __ATOMIC_ACQ_REL) & TRIPLE_INDEX;
+
+	return &triple->frames[triple->front];
+}
+
+/*
+ * Function:	simulation_sleep
+ * -----------------------------
+ * Sleep between steps, waking up every SIMULATION_POLL_MS to notice a quit.
+ *
+ * sim: the simulation.
+ * ms: the number of milliseconds to sleep.
+ */
+static void simulation_sleep(simulation_t *sim, uint32_t ms)
+{
+	uint32_t slept, slice;
+	struct timespec ts;
+
+	for (slept=0; slept < ms && !__atomic_load_n(&sim->quit, __ATOMIC_ACQUIRE); slept += slice) {
+		slice = ms - slept < SIMULATION_POLL_MS ? ms - slept : SIMULATION_POLL_MS;
+		ts.tv_sec = 0;
+		ts.tv_nsec = slice * 1000000L;
+		nanosleep(&ts, NULL);
+	}
+}
+
+/*
+ * Function:	simulation_changed
+ * -------------------------------
+ * Mark the tiles of a frame that may differ from the frame the window
+ * 	shows. The engine marks the tiles changed since the last published
+ * 	frame, the frames the window dropped since the one it shows add
+ * 	their own. The frame's changes are kept as unseen in case the window
+ * 	took the last published frame, see simulation_run.
+ *
+ * sim: the simulation.
+ * body: the body of the frame being published.
+ */
+static void simulation_changed(simulation_t *sim, body_t *body)
+{
+	size_t i;
+	uint8_t changed;
+
+	for (i=0; i < body->tile_rows * body->tile_cols; i++) {
+		changed = body->tiles[i].changed;
+		body->tiles[i].changed |= sim->unseen[i];
+		sim->unseen[i] = changed;
+	}
+}
+
+/*
+ * Function:	simulation_run
+ * ---------------------------
+ * Simulation thread loop, steps the engine and publishes every finished
+ * 	generation through the triple buffer until it is told to quit.
+ *
+ * arg: the simulation.
+ */
+static void *simulation_run(void *arg)
+{
+	simulation_t *sim = arg;
+	frame_t *frame;
+	uint64_t generations;
+	size_t i;
+
+	while (!__atomic_load_n(&sim->quit, __ATOMIC_ACQUIRE)) {
+		if (__atomic_load_n(&sim->pause, __ATOMIC_ACQUIRE)) {
+			simulation_sleep(sim, SIMULATION_POLL_MS);
+			continue;
+		}
+
+		/* Show the last generation for the delay before computing the next */
+		simulation_sleep(sim, __atomic_load_n(&sim->delay, __ATOMIC_RELAXED));
+		if (__atomic_load_n(&sim->quit, __ATOMIC_ACQUIRE) || __atomic_load_n(&sim->pause, __ATOMIC_ACQUIRE))
+			continue;
+
+		generations = (uint64_t)1 << __atomic_load_n(&sim->step_log, __ATOMIC_RELAXED);
+		engine->step(sim->state, generations);
+		sim->generation += generations;
+
+		frame = &sim->triple.frames[sim->triple.back];
+		engine->read(sim->state, frame->body);
+		frame->generation = sim->generation;
+		frame->population = engine->population(sim->state);
+		simulation_changed(sim, frame->body);
+
+		/* The window never saw a dropped frame, its changes stay unseen */
+		if (!triple_publish(&sim->triple))
+			for (i=0; i < frame->body->tile_rows * frame->body->tile_cols; i++)
+				sim->unseen[i] = frame->body->tiles[i].changed;
+
+		if (sim->step)
+			__atomic_store_n(&sim->pause, 1, __ATOMIC_RELEASE);
+	}
+
+	return NULL;
+}
+
+/*
+ * Function:	simulation_start
+ * -----------------------------
+ * Start the simulation thread. The engine's state is only touched by the
+ * 	thread until simulation_stop returns.
+ *
+ * state: the engine's state, loaded with the initial generation.
+ * body: the body holding the initial generation.
+ * population: the population of the initial generation.
+ * delay: the milliseconds between steps.
+ *
+ * returns: pointer to the newly allocated simulation.
+ */
+simulation_t *simulation_start(void *state, const body_t *body, uint64_t population, uint32_t delay)
+{
+	simulation_t *sim = malloc(sizeof(*sim));
+	if (!sim) {
+		perror("simulation_start: Failed to malloc sim");
+		exit(EXIT_FAILURE);
+	}
+
+	sim->state = state;
+	sim->generation = 0;
+	sim->pause = 0;
+	sim->quit = 0;
+	sim->step = step;
+	sim->delay = delay;
+	sim->step_log = 0;
+	triple_init(&sim->triple, body, population);
+
+	/* The window draws the first frame in full */
+	sim->unseen = malloc(body->tile_rows * body->tile_cols);
+	if (!sim->unseen) {
+		perror("simulation_start: Failed to malloc sim->unseen");
+		exit(EXIT_FAILURE);
+	}
+	memset(sim->unseen, 1, body->tile_rows * body->tile_cols);
+
+	if (pthread_create(&sim->thread, NULL, simulation_run, sim)) {
+		perror("simulation_start: Failed to create simulation thread");
+		exit(EXIT_FAILURE);
+	}
+
+	return sim;
+}
+
+/*
+ * Function:	simulation_stop
+ * ----------------------------
+ * Stop the simulation thread and free the simulation. The engine's state
+ * 	is left to the caller.
+ *
+ * sim: pointer to the simulation allocated in memory.
+ */
+void simulation_stop(simulation_t *sim)
+{
+	__atomic_store_n(&sim->quit, 1, __ATOMIC_RELEASE);
+	pthread_join(sim->thread, NULL);
+
+	triple_destroy(&sim->triple);
+	free(sim->unseen);
+	free(sim);
+}
@@ -0,0 +1,256 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cell.h"
+#include "sparse.h"
+#include "rule.h"
+
+#define SPARSE_HASH(key) ((key) * 0x9E3779B97F4A7C15ULL)
+
+/*
+ * Function:	sparse_init
+ * ------------------------
+ * Initialize an empty sparse universe.
+ *
+ * returns: pointer to the newly allocated universe.
+ */
+sparse_t *sparse_init(void)
+{
+	sparse_t *sp_new = calloc(1, sizeof(*sp_new));
+	if (!sp_new) {
+		perror("sparse_init: Failed to malloc sp_new");
+		exit(EXIT_FAILURE);
+	}
+
+	return sp_new;
+}
+
+/*
+ * Function:	sparse_destroy
+ * ---------------------------
+ * Destroy a sparse universe.
+ *
+ * sp: pointer to the universe allocated in memory.
+ */
+void sparse_destroy(sparse_t *sp)
+{
+	free(sp->live);
+	free(sp->tally_keys);
+	free(sp->tally_counts);
+	free(sp);
+}
+
+/*
+ * Function:	sparse_push
+ * ------------------------
+ * Append a cell to the list of live cells.
+ *
+ * sp: the universe.
+ * key: the coordinates of the cell.
+ */
+static void sparse_push(sparse_t *sp, uint64_t key)
+{
+	if (sp->count == sp->capacity) {
+		sp->capacity = sp->capacity ? sp->capacity * 2 : 1024;
+		sp->live = realloc(sp->live, sp->capacity * sizeof(*sp->live));
+		if (!sp->live) {
+			perror("sparse_push: Failed to realloc sp->live");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	sp->live[sp->count++] = key;
+}
+
+/*
+ * Function:	sparse_tally
+ * -------------------------
+ * Add to the tally of a cell, inserting the cell with linear probing.
+ *
+ * sp: the universe.
+ * key: the coordinates of the cell.
+ * amount: 1 for a live neighbor, SPARSE_TALLY_ALIVE for the cell itself.
+ */
+static void sparse_tally(sparse_t *sp, uint64_t key, uint8_t amount)
+{
+	size_t mask = sp->tally_capacity - 1;
+	size_t slot = SPARSE_HASH(key) >> 32 & mask;
+
+	while (sp->tally_counts[slot] && sp->tally_keys[slot] != key)
+		slot = (slot + 1) & mask;
+
+	sp->tally_keys[slot] = key;
+	sp->tally_counts[slot] += amount;
+}
+
+/*
+ * Function:	sparse_load
+ * ------------------------
+ * Replace the universe with the cells of a body. The body's top left cell
+ * 	is placed at the origin.
+ *
+ * sp: the universe being loaded.
+ * body: the body holding the cells.
+ */
+void sparse_load(sparse_t *sp, const body_t *body)
+{
+	size_t x, y;
+
+	sp->count = 0;
+	sp->duplicates = 0;
+	for (y=0; y < body->rows; y++)
+		for (x=0; x < body->cols; x++)
+			if (BODY_GET(body, x, y))
+				sparse_push(sp, SPARSE_KEY(x, y));
+}
+
+/*
+ * Function:	sparse_set
+ * -----------------------
+ * Make a cell alive without a body, however large the area it covers. A
+ * 	cell set twice is only counted once, see sparse_unique.
+ *
+ * sp: the universe.
+ * x: the column of the cell, the origin is the top left cell of the body.
+ * y: the row of the cell.
+ */
+void sparse_set(sparse_t *sp, int32_t x, int32_t y)
+{
+	sparse_push(sp, SPARSE_KEY(x, y));
+	sp->duplicates = 1;
+}
+
+/*
+ * Function:	sparse_compare
+ * ---------------------------
+ * Order two cell keys for qsort.
+ *
+ * a, b: pointers to the keys.
+ *
+ * returns: -1, 0, or 1 as a is before, equal to, or after b.
+ */
+static int sparse_compare(const void *a, const void *b)
+{
+	uint64_t ka = *(const uint64_t *)a, kb = *(const uint64_t *)b;
+
+	return (ka > kb) - (ka < kb);
+}
+
+/*
+ * Function:	sparse_unique
+ * --------------------------
+ * Drop the cells set more than once since the last step. A live cell
+ * 	must only be tallied once.
+ *
+ * sp: the universe.
+ */
+static void sparse_unique(sparse_t *sp)
+{
+	size_t i, count;
+
+	if (!sp->duplicates)
+		return;
+
+	qsort(sp->live, sp->count, sizeof(*sp->live), sparse_compare);
+	for (i=count=0; i < sp->count; i++)
+		if (!count || sp->live[i] != sp->live[count - 1])
+			sp->live[count++] = sp->live[i];
+
+	sp->count = count;
+	sp->duplicates = 0;
+}
+
+/*
+ * Function:	sparse_step
+ * ------------------------
+ * Advance the universe one generation. Every live cell adds one to the
+ * 	tally of each of its neighbors and flags itself alive, then the
+ * 	tallied cells that satisfy the rules become the new live cells. The
+ * 	work is proportional to the population, not the area.
+ *
+ * sp: the universe being advanced.
+ */
+void sparse_step(sparse_t *sp)
+{
+	size_t i, needed;
+	int32_t x, y;
+	uint8_t tally, neighbors;
+
+	sparse_unique(sp);
+
+	/* Keep the table at most 9/16 full, every live cell tallies 9 cells */
+	for (needed = 1024; needed < sp->count * 16; needed <<= 1);
+	if (needed != sp->tally_capacity) {
+		free(sp->tally_keys);
+		free(sp->tally_counts);
+		sp->tally_capacity = needed;
+		sp->tally_keys = malloc(needed * sizeof(*sp->tally_keys));
+		sp->tally_counts = malloc(needed * sizeof(*sp->tally_counts));
+		if (!sp->tally_keys || !sp->tally_counts) {
+			perror("sparse_step: Failed to malloc the tally table");
+			exit(EXIT_FAILURE);
+		}
+	}
+	memset(sp->tally_counts, 0, sp->tally_capacity);
+
+	for (i=0; i < sp->count; i++) {
+		x = SPARSE_KEY_X(sp->live[i]);
+		y = SPARSE_KEY_Y(sp->live[i]);
+
+		sparse_tally(sp, sp->live[i], SPARSE_TALLY_ALIVE);
+		sparse_tally(sp, SPARSE_KEY(x - 1, y - 1), 1);
+		sparse_tally(sp, SPARSE_KEY(x, y - 1), 1);
+		sparse_tally(sp, SPARSE_KEY(x + 1, y - 1), 1);
+		sparse_tally(sp, SPARSE_KEY(x - 1, y), 1);
+		sparse_tally(sp, SPARSE_KEY(x + 1, y), 1);
+		sparse_tally(sp, SPARSE_KEY(x - 1, y + 1), 1);
+		sparse_tally(sp, SPARSE_KEY(x, y + 1), 1);
+		sparse_tally(sp, SPARSE_KEY(x + 1, y + 1), 1);
+	}
+
+	sp->count = 0;
+	for (i=0; i < sp->tally_capacity; i++) {
+		tally = sp->tally_counts[i];
+		neighbors = tally & SPARSE_TALLY_COUNT;
+		if (RULE_NEXT(rule, tally & SPARSE_TALLY_ALIVE, neighbors))
+			sparse_push(sp, sp->tally_keys[i]);
+	}
+}
+
+/*
+ * Function:	sparse_read
+ * ------------------------
+ * Copy the live cells covered by a body into the body.
+ *
+ * sp: the universe being read.
+ * body: the body receiving the cells, its top left cell is the origin.
+ */
+void sparse_read(sparse_t *sp, body_t *body)
+{
+	size_t i;
+	int32_t x, y;
+
+	body_clear(body);
+	for (i=0; i < sp->count; i++) {
+		x = SPARSE_KEY_X(sp->live[i]);
+		y = SPARSE_KEY_Y(sp->live[i]);
+		if (x >= 0 && y >= 0 && (size_t)x < body->cols && (size_t)y < body->rows)
+			BODY_SET(body, x, y);
+	}
+}
+
+/*
+ * Function:	sparse_population
+ * ------------------------------
+ * Get the population of the whole universe.
+ *
+ * sp: the universe.
+ *
+ * returns: the number of live cells.
+ */
+uint64_t sparse_population(sparse_t *sp)
+{
+	sparse_unique(sp);
+	return sp->count;
+}
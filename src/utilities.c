@@ -1,13 +1,19 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <unistd.h>
+#include <getopt.h>
 #include <string.h>
 #include <limits.h>
-#include <SDL.h>
-#include <SDL_ttf.h>
+#include <inttypes.h>
+#include <time.h>
 
 #include "utilities.h"
 #include "cell.h"
+#include "kernel.h"
+#include "pool.h"
+#include "engine.h"
+#include "rule.h"
+#include "hashlife.h"
 
 /*
  * Function:	strremove
@@ -65,7 +71,7 @@ char *get_proj_dir(char *command)
  */
 static void print_usage(void)
 {
-        printf("usage: ./game_of_life [-h | [-sgn:d:p:c:b:m:]]\n");
+        printf("usage: ./game_of_life [-h | [-swgHSn:d:p:c:b:m:k:t:M:T:E:R:L:P:B:] [--headless N]]\n");
 	printf("\t: - needs value\n");
         printf("optional arguments:\n");
         printf("\t-h\t\t: Print the usage statement.\n");
@@ -77,6 +83,19 @@ static void print_usage(void)
 	printf("\t-c\t\t: Set cell color. (0xRRGGBB)\n");
 	printf("\t-b\t\t: Set background color. (0xRRGGBB)\n");
 	printf("\t-m\t\t: Select mode. (r: random, p: pattern, d: drawing)\n");
+	printf("\t-k\t\t: Select kernel. (auto, avx512, avx2, sse2, scalar, rule, generations, ltl, isotropic, lut, colsum, naive)\n");
+	printf("\t-t\t\t: Number of threads computing each generation.\n");
+	printf("\t-w\t\t: Pipeline generations across the threads, one generation per thread. (dead edges)\n");
+	printf("\t-E\t\t: Select engine. (reference, hashlife, sparse)\n");
+	printf("\t-H\t\t: Use the HashLife engine, same as -E hashlife. (unbounded universe)\n");
+	printf("\t-M\t\t: HashLife node cache size in megabytes. (collected between steps, a step may go over)\n");
+	printf("\t-S\t\t: Use the sparse engine, same as -E sparse. (unbounded universe)\n");
+	printf("\t-T\t\t: Select topology. (dead, torus, klein, cross)\n");
+	printf("\t-L\t\t: Tile size in rows and words of 64 cells. (RxW, 0x0 tunes to the caches)\n");
+	printf("\t-P\t\t: Generations computed per pass over the body. (1-%d)\n", TILE_GENERATIONS_MAX);
+	printf("\t-B\t\t: Benchmark N generations without a window and print the throughput.\n");
+	printf("\t--headless\t: Run N generations of the selected mode without a window and print the statistics.\n");
+	printf("\t-R\t\t: Set the rule. (B/S notation, e.g. B36/S23, B2-a/S12, B2/S/C3, or R5,C0,M1,S34..58,B34..45,NM)\n");
 }
 
 /*
@@ -153,10 +172,15 @@ char *parse_pattern_choice(void)
 void parse_input(int argc, char *argv[])
 {
 	int option;
+	char *kernel_name = KERNEL_DEFAULT;
+	static const struct option long_options[] = {
+		{ "headless", required_argument, NULL, OPTION_HEADLESS },
+		{ NULL, 0, NULL, 0 }
+	};
 
 	proj_dir = get_proj_dir(argv[0]);
 
-	while ((option = getopt(argc, argv, ":hsgn:d:p:c:b:m:")) != -1) {
+	while ((option = getopt_long(argc, argv, ":hswgHSn:d:p:c:b:m:k:t:M:T:E:R:L:P:B:", long_options, NULL)) != -1) {
 		switch (option) {
 			case 'h': /* Print usage */
 				goto usage_and_exit;
@@ -192,6 +216,61 @@ void parse_input(int argc, char *argv[])
 					goto usage_and_exit;
 				}
 				break;
+			case 'k': /* Kernel, looked up once the rule is known */
+				kernel_name = optarg;
+				break;
+			case 't': /* Threads */
+				threads = atoi(optarg);
+				break;
+			case 'w': /* Wavefront */
+				wavefront = 1;
+				break;
+			case 'E': /* Engine */
+				engine = engine_find(optarg);
+				if (!engine) { /* Unknown engine */
+					fprintf(stderr, "game_of_life: engine %s is not available.\n", optarg);
+					engine_print_choices();
+					goto usage_and_exit;
+				}
+				break;
+			case 'H': /* HashLife */
+				engine = engine_find("hashlife");
+				break;
+			case 'M': /* HashLife node cache */
+				hashlife_meta.cache_mb = atoi(optarg);
+				break;
+			case 'S': /* Sparse */
+				engine = engine_find("sparse");
+				break;
+			case 'T': /* Topology */
+				cell_meta.topology = topology_find(optarg);
+				if (cell_meta.topology < 0) { /* Unknown topology */
+					fprintf(stderr, "game_of_life: topology %s is not available.\n", optarg);
+					topology_print_choices();
+					goto usage_and_exit;
+				}
+				break;
+			case 'R': /* Rule */
+				if (rule_parse(optarg, &rule)) {
+					fprintf(stderr, "game_of_life: %s is not a valid rule (e.g. B3/S23).\n", optarg);
+					goto usage_and_exit;
+				}
+				break;
+			case 'L': /* Tile size */
+				if (sscanf(optarg, "%dx%d", &tile_meta.rows, &tile_meta.words) != 2) {
+					fprintf(stderr, "game_of_life: %s is not a tile size (e.g. 32x8).\n", optarg);
+					goto usage_and_exit;
+				}
+				break;
+			case 'P': /* Generations per pass */
+				tile_meta.generations = atoi(optarg);
+				break;
+			case 'B': /* Benchmark */
+				benchmark = strtoull(optarg, NULL, 10);
+				break;
+			case OPTION_HEADLESS: /* No window */
+				headless = strtoull(optarg, NULL, 10);
+				break;
 			case ':': /* Needs value */
 				fprintf(stderr, "game_of_life: option needs value.\n");
 				goto usage_and_exit;
@@ -204,15 +283,72 @@ void parse_input(int argc, char *argv[])
 	bg_meta.width = cell_meta.width * cell_meta.cols;
 	bg_meta.height = cell_meta.height * cell_meta.rows;
 
-	if ((bg_meta.width > MAX_WINDOW_WIDTH) || (bg_meta.height > MAX_WINDOW_HEIGHT) ||
-	    (bg_meta.width < MIN_WINDOW_WIDTH) || (bg_meta.height < MIN_WINDOW_HEIGHT) ) { /* Invalid cell dims. */
+#ifdef GOL_HEADLESS
+	if (!benchmark && !headless) { /* Built without the window */
+		fprintf(stderr, "game_of_life: built without a window, run with --headless N or -B N\n");
+		goto usage_and_exit;
+	}
+#endif
+
+	if (!benchmark && !headless && ((bg_meta.width > MAX_WINDOW_WIDTH) || (bg_meta.height > MAX_WINDOW_HEIGHT) ||
+	    (bg_meta.width < MIN_WINDOW_WIDTH) || (bg_meta.height < MIN_WINDOW_HEIGHT))) { /* Invalid cell dims. */
 		fprintf(stderr, "game_of_life: invalid window size (too small/large)\n");
 		goto usage_and_exit;
 	}
+	else if (benchmark && (cell_meta.rows < 1 || mode != 'r')) { /* No window to draw in */
+		fprintf(stderr, "game_of_life: the benchmark needs a body and random mode\n");
+		goto usage_and_exit;
+	}
+	else if (headless && (cell_meta.rows < 1 || mode == 'd')) { /* No window to draw in */
+		fprintf(stderr, "game_of_life: headless mode needs a body and random or pattern mode\n");
+		goto usage_and_exit;
+	}
 	else if ((cell_meta.alive_prob > 100) || (cell_meta.alive_prob < 0)) { /* Prob. must be percentage 0-100 */
 		fprintf(stderr, "game_of_life: probability value must be a 0-100\n");
 		goto usage_and_exit;
 	}
+	else if ((threads < 1) || (threads > POOL_MAX_THREADS)) {
+		fprintf(stderr, "game_of_life: thread count must be 1-%d\n", POOL_MAX_THREADS);
+		goto usage_and_exit;
+	}
+	else if ((tile_meta.generations < 1) || (tile_meta.generations > TILE_GENERATIONS_MAX)) {
+		fprintf(stderr, "game_of_life: generations per pass must be 1-%d\n", TILE_GENERATIONS_MAX);
+		goto usage_and_exit;
+	}
+	else if (hashlife_meta.cache_mb < 1) {
+		fprintf(stderr, "game_of_life: HashLife cache size must be at least 1 MB\n");
+		goto usage_and_exit;
+	}
+
+	if (!engine)
+		engine = engine_find(ENGINE_DEFAULT);
+	if (engine->unbounded && cell_meta.topology != TOPOLOGY_DEAD) {
+		fprintf(stderr, "game_of_life: the %s engine only runs unbounded universes\n", engine->name);
+		goto usage_and_exit;
+	}
+	else if (!(engine->rules & rule_family(&rule))) {
+		fprintf(stderr, "game_of_life: the %s engine does not run this rule\n", engine->name);
+		goto usage_and_exit;
+	}
+	else if (rule.radius >= cell_meta.rows || rule.radius >= cell_meta.cols) {
+		fprintf(stderr, "game_of_life: the body must be larger than the rule's radius\n");
+		goto usage_and_exit;
+	}
+	else if (tile_meta.rows < 0 || tile_meta.rows > TILE_ROWS_MAX || tile_meta.words < 0 || tile_meta.words > TILE_WORDS_MAX) {
+		fprintf(stderr, "game_of_life: tiles must have 0-%d rows and 0-%d words\n", TILE_ROWS_MAX, TILE_WORDS_MAX);
+		goto usage_and_exit;
+	}
+	else if (engine->unbounded && (rule.birth & RULE_N(0))) { /* Empty space would be born */
+		fprintf(stderr, "game_of_life: the %s engine cannot run rules with B0\n", engine->name);
+		goto usage_and_exit;
+	}
+
+	kernel = kernel_find(kernel_name);
+	if (!kernel) { /* Unknown or unsupported kernel */
+		fprintf(stderr, "game_of_life: kernel %s is not available.\n", kernel_name);
+		kernel_print_choices();
+		goto usage_and_exit;
+	}
 
 	for(; optind < argc; optind++) { /* Extra args */
 		fprintf(stderr, "game_of_life: invalid option %s.\n", argv[optind]);
@@ -227,96 +363,90 @@ usage_and_exit:
 }
 
 /*
- * Function:	display_text
- * -------------------------
- * Display text on the window.
+ * Function:	benchmark_fill
+ * ---------------------------
+ * Seed the whole body with alive cells at the alive probability, so every
+ * 	tile is computed and not just the center of random mode.
  *
- * renderer: SDL_Renderer used for rendering the text.
- * color: the color for rendering the text.
- * x: the column to start rendering the text.
- * y: the row to start rendering the text.
- * w: the width of the text box.
- * h: the height of the text box.
+ * state: the engine's state being seeded.
  */
-void display_text(SDL_Renderer *renderer, char *text, SDL_Color color, int font_size, int x, int y, int w, int h)
+static void benchmark_fill(void *state)
 {
-	TTF_Font* font;
-	SDL_Surface* surface_message;
-	SDL_Texture* texture_message;
-	SDL_Rect message_rect;
-	char *font_path;
-	char font_rel_path[] = "/data/assets/Arial.ttf";
-
-	font_path = malloc(strlen(proj_dir) + strlen(font_rel_path) + 1);
-	if (!font_path) {
-		perror("display_text: Failed to malloc font_path");
-		exit(EXIT_FAILURE);
-	}
-	strcpy(font_path, proj_dir);
-	strcat(font_path, font_rel_path);
-
-	font = TTF_OpenFont(font_path, font_size);
-	if (!font) {
-		printf("%s\n", TTF_GetError());
-		perror("display_body_statistics: TTF_OpenFont failed");
-		exit(EXIT_FAILURE);
-	}
-	free(font_path);
-
-	surface_message = TTF_RenderText_Solid(font, text, color);
-	if (!surface_message) {
-		perror("display_body_statistics: TTF_RenderText_Solid failed");
-		exit(EXIT_FAILURE);
-	}
-
-	texture_message = SDL_CreateTextureFromSurface(renderer, surface_message);
-	if (!texture_message) {
-		perror("display_body_statistics: SDL_CreateTextureFromSurface failed");
-		exit(EXIT_FAILURE);
-	}
-
-	message_rect.x = x;
-	message_rect.y = y;
-	message_rect.w = w;
-	message_rect.h = h;
-
-	if (SDL_QueryTexture(texture_message, NULL, NULL, &message_rect.w, &message_rect.h) == -1) {
-		perror("display_body_statistics: SDL_QueryTexture failed");
-		exit(EXIT_FAILURE);
-	}
-
-	if (SDL_RenderCopy(renderer, texture_message, NULL, &message_rect) == -1) {
-		perror("display_body_statistics: SDL_RenderCopy failed to display the message");
-		exit(EXIT_FAILURE);
+	size_t x, y;
+	uint64_t seed = ((uint64_t)rand() << 32) | rand() | 1;
+
+	for (y=0; y < (size_t)cell_meta.rows; y++) {
+		for (x=0; x < (size_t)cell_meta.cols; x++) {
+			seed ^= seed << 13; /* xorshift, rand is too slow for large bodies */
+			seed ^= seed >> 7;
+			seed ^= seed << 17;
+			if ((int)(seed % 100) < cell_meta.alive_prob)
+				engine->set(state, x, y);
+		}
 	}
+}
 
-	TTF_CloseFont(font);
-	SDL_FreeSurface(surface_message);
-	SDL_DestroyTexture(texture_message);
+/*
+ * Function:	run_batch
+ * ----------------------
+ * Step the selected engine as fast as it goes without opening a window
+ * 	and print the final statistics and the throughput, the size of the
+ * 	body times the generations over the time taken.
+ *
+ * state: the engine's state holding the initial generation.
+ * generations: the number of generations to compute.
+ */
+static void run_batch(void *state, uint64_t generations)
+{
+	struct timespec start, end;
+	double seconds;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	engine->step(state, generations);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+	printf("engine %s, kernel %s, %d threads, %dx%d cells, %dx%d tiles\n", engine->name, kernel->name,
+			threads, cell_meta.rows, cell_meta.cols, tile_meta.rows, tile_meta.words);
+	printf("%" PRIu64 " generations in %.3f s, population %" PRIu64 ", %.1f generations/s, %.1f M cell updates/s\n",
+			generations, seconds, engine->population(state), generations / seconds,
+			(double)cell_meta.rows * cell_meta.cols * generations / seconds / 1e6);
 }
 
 /*
- * Function:	display_body_statistics
- * ------------------------------------
- * Display the current generation and population.
+ * Function:	run_benchmark
+ * --------------------------
+ * Benchmark the selected engine on the whole body seeded at the alive
+ * 	probability, see run_batch.
  *
- * renderer: SDL_Renderer used for rendering the statistics.
- * gen: the current generation count.
- * pop: the current population count.
+ * generations: the number of generations to compute.
  */
-void display_body_statistics(SDL_Renderer *renderer, int gen, int pop)
+void run_benchmark(uint64_t generations)
 {
-	char text[124];
-	SDL_Color color;
+	void *state;
 
-	if (cell_meta.grid_on)
-		color.r = color.g = color.b = 0; /* Black */
-	else
-		color.r = color.g = color.b = 101; /* Light Gray */
+	state = engine->init(cell_meta.rows, cell_meta.cols);
+	benchmark_fill(state);
+	run_batch(state, generations);
+	engine->destroy(state);
+}
 
-	sprintf(text, "Current Generation: %d", gen);
-	DISPLAY_STAT(renderer, text, color, 25);
+/*
+ * Function:	run_headless
+ * -------------------------
+ * Run the selected mode without a window, for batch jobs on machines
+ * 	without a display, see run_batch. The unbounded engines are seeded
+ * 	without a body, so the area is only limited by the live cells.
+ *
+ * generations: the number of generations to compute.
+ */
+void run_headless(uint64_t generations)
+{
+	uint64_t population;
+	void *state;
 
-	sprintf(text, "Population: %d", pop);
-	DISPLAY_STAT(renderer, text, color, 50);
+	state = engine->init(cell_meta.rows, cell_meta.cols);
+	if (inital_generation(state, &population))
+		run_batch(state, generations);
+	engine->destroy(state);
 }